@@ -0,0 +1,338 @@
+// ==============================================================================
+/**
+ * arenatest.c
+ *
+ * Check the arenas' headerless blocks.  They are carved to the byte; and those
+ * of `pb_raw_footprint()` sizes, freed in LIFO order, are handed back exactly:
+ * after a nest of them, of odd sizes, is unwound with `pb_arena_free_raw()`,
+ * the arena's cursors must be back where they started, over a heap arena and
+ * over a buffer whose end is not aligned.  A child arena must refill with a
+ * chunk that holds a block larger than its chunk size, with or without a
+ * header; rewind across its chunks; and, with its children, be reset and
+ * destroyed, handing every chunk back to its parent.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** The depth of each nest, and the odd sizes cycled through. */
+#define DEPTH 64
+static const size_t sizes[] = { 1, 3, 7, 9, 13, 17, 31, 33, 45, 100, 127, 255 };
+#define SIZES (sizeof(sizes) / sizeof(sizes[0]))
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate from `arena` as callers do: inline, then out of line if that fails.
+ */
+static void* alloc (pb_arena_s* arena, size_t size) {
+
+  void* block = pb_arena_alloc(arena, size);
+  return block != NULL ? block : pb_arena_alloc_slow(arena, size);
+
+} // alloc ()
+
+
+
+static void* alloc_raw (pb_arena_s* arena, size_t size, size_t align) {
+
+  void* block = pb_arena_alloc_raw(arena, size, align);
+  return block != NULL ? block : pb_arena_alloc_raw_slow(arena, size, align);
+
+} // alloc_raw ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a nest of blocks of odd sizes from `arena`, then free them newest
+ * first, checking that each is aligned and that the cursors come back.
+ *
+ * \param arena The region to allocate from.
+ * \param align The alignment to ask for; at most `PB_ALIGNMENT`.
+ */
+static void check (pb_arena_s* arena, size_t align) {
+
+  for (size_t first = 0; first < SIZES; first++) {
+    pb_mark_s start = pb_arena_mark(arena);
+    char*     blocks[DEPTH];
+    for (int i = 0; i < DEPTH; i++) {
+      size_t size = sizes[(first + i) % SIZES];
+      blocks[i] = pb_arena_alloc_raw(arena, pb_raw_footprint(size), align);
+      assert(blocks[i] != NULL);
+      assert((uintptr_t)blocks[i] % align == 0);
+    }
+    for (int i = DEPTH - 1; i >= 0; i--) {
+      pb_arena_free_raw(arena, blocks[i], pb_raw_footprint(sizes[(first + i) % SIZES]));
+    }
+    assert(arena->free_addr == start.free_addr);  // every block should have
+    assert(arena->end_addr  == start.end_addr);   // come back
+  }
+
+} // check ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Check that blocks with no alignment to speak of are carved to the byte, with
+ * nothing lost to rounding.
+ *
+ * \param arena The region to allocate from.
+ */
+static void check_dense (pb_arena_s* arena) {
+
+  pb_mark_s start = pb_arena_mark(arena);
+  char*     a     = pb_arena_alloc_raw(arena, 5, 1);
+  char*     b     = pb_arena_alloc_raw(arena, 3, 1);
+  assert(a != NULL && b != NULL);
+#if !defined (PB_BUMP_DOWN)
+  assert(b + 3 == a);
+  assert(arena->end_addr == start.end_addr - 8);
+#else
+  assert(a + 5 == b);
+  assert(arena->free_addr == start.free_addr + 8);
+#endif
+  pb_arena_free_raw(arena, b, 3);
+  pb_arena_free_raw(arena, a, 5);
+  assert(arena->free_addr == start.free_addr);
+  assert(arena->end_addr  == start.end_addr);
+
+} // check_dense ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Check that a fresh child arena refills with a chunk that holds a headerless
+ * block larger than its chunk size, aligned to `align`, for a run of sizes that
+ * covers every rounding of the block and the chunk.
+ *
+ * \param align The alignment to ask for.
+ */
+static void check_child_raw (size_t align) {
+
+  for (size_t size = 4096 - 64; size <= 4096 + 1024; size++) {
+    pb_arena_s child;
+    pb_arena_init_child(&child, &pb_heap, 4096);
+    char* block = pb_arena_alloc_raw_slow(&child, size, align);
+    assert(block != NULL);
+    assert((uintptr_t)block % align == 0);
+    assert(block >= child.start_addr && block + size <= child.limit_addr);
+    pb_arena_destroy(&child);
+  }
+
+} // check_child_raw ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Check that a child of `root` refills past its chunk size for blocks with and
+ * without headers, and that destroying it hands every chunk back.
+ *
+ * \param root The arena to carve the child's chunks from.
+ */
+static void check_child_refill (pb_arena_s* root) {
+
+  static const size_t big[] = { 4096, 5000, 9000, 20000, 70001 };
+  pb_mark_s  home = pb_arena_mark(root);
+  pb_arena_s child;
+  pb_arena_init_child(&child, root, 4096);
+
+  for (size_t i = 0; i < sizeof(big) / sizeof(big[0]); i++) {
+    char* block = pb_arena_alloc_slow(&child, big[i]);
+    assert(block != NULL);
+    assert((uintptr_t)block % PB_ALIGNMENT == 0);
+    assert(((pb_header_s*)block)[-1].size == big[i]);
+    assert(block >= child.start_addr && block + big[i] <= child.limit_addr);
+    memset(block, 0xab, big[i]);
+
+    char* raw = pb_arena_alloc_raw_slow(&child, big[i] + 1, 64);
+    assert(raw != NULL);
+    assert((uintptr_t)raw % 64 == 0);
+    assert(raw >= child.start_addr && raw + big[i] + 1 <= child.limit_addr);
+    memset(raw, 0xcd, big[i] + 1);
+  }
+
+  // Small blocks, enough to fill several chunks.
+  for (int i = 0; i < 4096; i++) {
+    char* block = alloc(&child, 100);
+    assert(block != NULL);
+    memset(block, 0xef, 100);
+  }
+
+  pb_arena_destroy(&child);
+  assert(root->free_addr == home.free_addr);  // every chunk should have
+  assert(root->end_addr  == home.end_addr);   // come back
+  assert(root->first_child == NULL);
+
+} // check_child_refill ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Check that rewinding a child to a mark taken in an earlier chunk puts its
+ * cursors back in that chunk, and that allocation resumes there.
+ *
+ * \param root The arena to carve the child's chunks from.
+ */
+static void check_child_rewind (pb_arena_s* root) {
+
+  pb_mark_s  home = pb_arena_mark(root);
+  pb_arena_s child;
+  pb_arena_init_child(&child, root, 4096);
+
+  assert(pb_arena_alloc_slow(&child, 100) != NULL);
+  char*     first_start = child.start_addr;
+  char*     first_limit = child.limit_addr;
+  pb_mark_s mark        = pb_arena_mark(&child);
+
+  // Fill that chunk and a few more.
+  for (int i = 0; i < 64; i++) {
+    assert(alloc(&child, 1000) != NULL);
+  }
+  assert(child.start_addr != first_start);
+
+  pb_arena_rewind(&child, mark);
+  assert(child.free_addr == mark.free_addr);
+  assert(child.end_addr  == mark.end_addr);
+  char* again = pb_arena_alloc(&child, 100);
+  char* raw   = pb_arena_alloc_raw(&child, 100, 16);
+  assert(again != NULL && again >= first_start && again + 100 <= first_limit);
+  assert(raw   != NULL && raw   >= first_start && raw   + 100 <= first_limit);
+
+  // Marks and rewinds within the first chunk still work as in any arena.
+  pb_mark_s inner = pb_arena_mark(&child);
+  assert(pb_arena_alloc(&child, 200) != NULL);
+  pb_arena_rewind(&child, inner);
+  assert(child.free_addr == inner.free_addr);
+  assert(child.end_addr  == inner.end_addr);
+
+  pb_arena_destroy(&child);
+  assert(root->free_addr == home.free_addr);
+  assert(root->end_addr  == home.end_addr);
+
+} // check_child_rewind ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Check that resetting and then destroying an arena with live children, and a
+ * grandchild, empties and then destroys them all, and hands every chunk back.
+ *
+ * \param root The arena to carve the family's chunks from.
+ */
+static void check_child_family (pb_arena_s* root) {
+
+  pb_mark_s  home = pb_arena_mark(root);
+  pb_arena_s parent, a, b, grandchild;
+  pb_arena_init_child(&parent,     root,    4096);
+  pb_arena_init_child(&a,          &parent, 4096);
+  pb_arena_init_child(&b,          &parent, 8192);
+  pb_arena_init_child(&grandchild, &a,      4096);
+
+  // Interleave the allocations, so that the chunks of each are scattered
+  // through those of its parent.
+  for (int i = 0; i < 16; i++) {
+    assert(alloc(&parent, 300) != NULL);
+    assert(alloc(&a, 700) != NULL);
+    assert(alloc_raw(&grandchild, 900, 8) != NULL);
+    assert(alloc(&b, 5000) != NULL);
+  }
+
+  // Resetting the parent empties every arena below it, which refill when next
+  // used, from the parent's memory.
+  pb_arena_reset(&parent);
+  assert(a.start_addr == NULL && b.start_addr == NULL);
+  assert(grandchild.start_addr == NULL && grandchild.chunks == NULL);
+  char* block = alloc(&grandchild, 100);
+  assert(block != NULL);
+  assert(a.start_addr != NULL && parent.start_addr != NULL);
+  assert(block >= a.start_addr && block < a.limit_addr);
+
+  // Destroying the parent destroys its children first, and leaves them all
+  // zeroed, detached and holding nothing.
+  pb_arena_destroy(&parent);
+  assert(root->free_addr == home.free_addr);
+  assert(root->end_addr  == home.end_addr);
+  assert(root->first_child == NULL);
+  assert(a.parent == NULL && a.chunks == NULL && a.first_child == NULL);
+  assert(b.parent == NULL && b.chunks == NULL);
+  assert(grandchild.parent == NULL && grandchild.chunks == NULL);
+  assert(parent.parent == NULL && parent.first_child == NULL);
+
+} // check_child_family ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_arena_s arena;
+  if (!pb_arena_init(&arena, 1 << 20)) {
+    fprintf(stderr, "Could not make an arena\n");
+    return 1;
+  }
+  check(&arena, 16);
+  check(&arena, 8);
+  check(&arena, 1);
+  check_dense(&arena);
+  pb_arena_destroy(&arena);
+
+  // A buffer with neither end aligned.
+  static char buffer[(1 << 16) + 64];
+  if (!pb_arena_init_buffer(&arena, buffer + 3, (1 << 16) + 5)) {
+    fprintf(stderr, "Could not make an arena over a buffer\n");
+    return 1;
+  }
+  check(&arena, 16);
+  check(&arena, 1);
+
+  check_child_raw(1);
+  check_child_raw(8);
+  check_child_raw(16);
+
+  pb_arena_s root;
+  if (!pb_arena_init(&root, 1 << 22)) {
+    fprintf(stderr, "Could not make an arena for children\n");
+    return 1;
+  }
+  check_child_refill(&root);
+  check_child_rewind(&root);
+  check_child_family(&root);
+  check_child_refill(&pb_heap);
+  pb_arena_destroy(&root);
+
+  printf("arenatest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================
@@ -0,0 +1,136 @@
+// ==============================================================================
+/**
+ * bench-batch.c
+ *
+ * Cycles per block for `pb_malloc_batch()` and `pb_malloc_many()` versus a loop
+ * of calls to `malloc()` or of inline `pb_malloc()`s.  As in bench-inline.c,
+ * each round rewinds the heap so that its pages stay warm.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** Blocks per round, and rounds per measurement. */
+#define BLOCKS 4096
+#define ROUNDS 2000
+
+/** The size of every block in the same-size measurements. */
+#define BLOCK_SIZE 40
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/** The blocks of the current round. */
+static void*  blocks[BLOCKS];
+
+/** The sizes used by the variable-size measurements. */
+static size_t sizes[BLOCKS];
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The contenders.
+
+static void run_malloc_same (void) {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    blocks[i] = malloc(BLOCK_SIZE);
+  }
+}
+
+static void run_pb_malloc_same (void) {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    blocks[i] = pb_malloc(BLOCK_SIZE);
+  }
+}
+
+static void run_batch (void) {
+  pb_malloc_batch(BLOCK_SIZE, BLOCKS, blocks);
+}
+
+static void run_malloc_varied (void) {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    blocks[i] = malloc(sizes[i]);
+  }
+}
+
+static void run_pb_malloc_varied (void) {
+  for (size_t i = 0; i < BLOCKS; i++) {
+    blocks[i] = pb_malloc(sizes[i]);
+  }
+}
+
+static void run_many (void) {
+  pb_malloc_many(sizes, BLOCKS, blocks);
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one contender, keeping the fastest round.
+ *
+ * \param name The label to print.
+ * \param run  The contender.
+ */
+static void measure (const char* name, void (*run) (void)) {
+
+  pb_arena_s saved = pb_heap;
+  uint64_t   best  = UINT64_MAX;
+  for (int round = 0; round < ROUNDS; round++) {
+    uint64_t start = bench_cycles();
+    run();
+    uint64_t cycles = bench_cycles() - start;
+    if (cycles < best) {
+      best = cycles;
+    }
+    pb_heap = saved;
+  }
+
+  printf("%-16s %6.2f cycles/block\n", name, (double)best / BLOCKS);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  for (size_t i = 0; i < BLOCKS; i++) {
+    sizes[i] = 8 + (size_t)(rand() % 120);
+  }
+
+  // Initialize the heap outside of any measurement.
+  free(malloc(1));
+
+  measure("malloc loop",    run_malloc_same);
+  measure("pb_malloc loop", run_pb_malloc_same);
+  measure("pb_malloc_batch", run_batch);
+  measure("malloc varied",  run_malloc_varied);
+  measure("pb_malloc varied", run_pb_malloc_varied);
+  measure("pb_malloc_many", run_many);
+
+  return 0;
+
+} // main()
+// ==============================================================================
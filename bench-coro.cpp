@@ -0,0 +1,203 @@
+// ==============================================================================
+/**
+ * bench-coro.cpp
+ *
+ * The cost of coroutine frames bumped from a task's arena through
+ * `pb::arena_frames` versus frames from the global `operator new`.  Each round
+ * runs one task: either a deep chain of nested `co_await`s, or a sequence of
+ * short-lived ones, as a loop issuing I/O operations would make.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <coroutine>
+#include <cstdint>
+#include <cstdio>
+#include <exception>
+
+#include "bench.h"
+#include "pb-coroutine.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Frames per round, and rounds per measurement. */
+static constexpr int frames = 1 << 12;
+static constexpr int rounds = 2000;
+
+/** The size of each task's arena. */
+static constexpr std::size_t capacity = std::size_t(4) << 20;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * A lazily started coroutine yielding an `int`, which resumes whoever awaits
+ * it when it finishes.  `Frames` supplies the promise's `operator new` and
+ * `operator delete`, if any.
+ */
+template <typename Frames>
+class task {
+
+public:
+
+  struct promise_type : Frames {
+
+    int                     value = 0;
+    std::coroutine_handle<> continuation;
+
+    task get_return_object () noexcept {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend () noexcept { return {}; }
+
+    struct final_awaiter {
+      bool await_ready () noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend (std::coroutine_handle<promise_type> self) noexcept {
+	return self.promise().continuation;
+      }
+      void await_resume () noexcept {}
+    };
+
+    final_awaiter final_suspend () noexcept { return {}; }
+
+    void return_value (int result) noexcept { value = result; }
+
+    void unhandled_exception () noexcept { std::terminate(); }
+
+  };
+
+  task (task&& other) noexcept
+    : handle_(other.handle_) {
+    other.handle_ = nullptr;
+  }
+
+  ~task () {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready () noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend (std::coroutine_handle<> caller) noexcept {
+    handle_.promise().continuation = caller;
+    return handle_;
+  }
+
+  int await_resume () noexcept { return handle_.promise().value; }
+
+  /** Run the task to completion from outside any coroutine. */
+  int run () {
+    handle_.promise().continuation = std::noop_coroutine();
+    handle_.resume();
+    return handle_.promise().value;
+  }
+
+private:
+
+  explicit task (std::coroutine_handle<promise_type> handle) noexcept
+    : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+
+}; // class task
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The workloads.
+
+/** Frames from the global `operator new`. */
+struct default_frames {};
+
+/** A chain of `depth` nested `co_await`s, unwound in LIFO order. */
+template <typename Frames>
+static task<Frames> chain (int depth) {
+  if (depth == 0) {
+    co_return 0;
+  }
+  co_return 1 + co_await chain<Frames>(depth - 1);
+}
+
+/** A single step, standing in for an I/O operation. */
+template <typename Frames>
+static task<Frames> step (int value) {
+  co_return value;
+}
+
+/** A task awaiting `count` steps, one after another. */
+template <typename Frames>
+static task<Frames> steps (int count) {
+  int sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += co_await step<Frames>(i);
+  }
+  co_return sum;
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one workload, keeping the fastest round.
+ *
+ * \param name  The workload's label.
+ * \param arena The task's arena, or null for the global `operator new`.
+ * \param make  The workload.
+ */
+template <typename Frames>
+static void measure (const char* name, pb_arena_s* arena, task<Frames> (*make) (int)) {
+
+  std::uint64_t best = UINT64_MAX;
+  for (int round = 0; round < rounds; round++) {
+    std::uint64_t start = bench_cycles();
+    if (arena != nullptr) {
+      pb::frame_scope scope(arena);
+      BENCH_KEEP(make(frames).run());
+    } else {
+      BENCH_KEEP(make(frames).run());
+    }
+    std::uint64_t cycles = bench_cycles() - start;
+    best = cycles < best ? cycles : best;
+  }
+  std::printf("%-8s %-14s %7.2f cycles/frame\n", name,
+	      arena != nullptr ? "pb::arena" : "operator new",
+	      (double)best / frames);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_arena_s arena;
+  if (!pb_arena_init(&arena, capacity)) {
+    std::fprintf(stderr, "Could not make an arena\n");
+    return 1;
+  }
+
+  measure<default_frames>("chain", nullptr, chain<default_frames>);
+  measure<pb::arena_frames>("chain", &arena, chain<pb::arena_frames>);
+  measure<default_frames>("steps", nullptr, steps<default_frames>);
+  measure<pb::arena_frames>("steps", &arena, steps<pb::arena_frames>);
+
+  pb_arena_destroy(&arena);
+  return 0;
+
+} // main()
+// ==============================================================================
@@ -0,0 +1,112 @@
+// ==============================================================================
+/**
+ * bench-inline.c
+ *
+ * Cycles per allocation through the inline fast paths in `pb-alloc.h` versus a
+ * call into libpb.so's `malloc()`.  Each round rewinds the heap so that every
+ * round reuses the same, already faulted-in pages.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** Allocations per round, and rounds per measurement. */
+#define ALLOCS (1 << 12)
+#define ROUNDS 2000
+
+/** The sizes cycled through by the mixed-size measurements. */
+#define SIZE_COUNT 8
+static const size_t sizes[SIZE_COUNT] = { 8, 24, 16, 40, 32, 8, 64, 24 };
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The contenders.  Each is its own function so that every one of them pays for
+// the loop in the same way; only the allocation itself differs.
+
+static void run_malloc (size_t mask) {
+  for (size_t i = 0; i < ALLOCS; i++) {
+    void* block = malloc(sizes[i & mask]);
+    BENCH_KEEP(block);
+  }
+}
+
+static void run_pb_malloc (size_t mask) {
+  for (size_t i = 0; i < ALLOCS; i++) {
+    void* block = pb_malloc(sizes[i & mask]);
+    BENCH_KEEP(block);
+  }
+}
+
+static void run_pb_alloc_raw (size_t mask) {
+  for (size_t i = 0; i < ALLOCS; i++) {
+    void* block = pb_alloc_raw(sizes[i & mask], 8);
+    BENCH_KEEP(block);
+  }
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one contender, keeping the fastest round.
+ *
+ * \param name The label to print.
+ * \param run  The contender.
+ * \param mask Zero to always allocate the first size, `SIZE_COUNT - 1` to cycle.
+ */
+static void measure (const char* name, void (*run) (size_t), size_t mask) {
+
+  pb_arena_s saved = pb_heap;
+  uint64_t   best  = UINT64_MAX;
+  for (int round = 0; round < ROUNDS; round++) {
+    uint64_t start = bench_cycles();
+    run(mask);
+    uint64_t cycles = bench_cycles() - start;
+    if (cycles < best) {
+      best = cycles;
+    }
+    pb_heap = saved;
+  }
+
+  printf("%-14s %-6s %6.2f cycles/alloc\n",
+	 name, mask == 0 ? "fixed" : "mixed", (double)best / ALLOCS);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  // Initialize the heap outside of any measurement.
+  free(malloc(1));
+
+  for (size_t mask = 0; mask < SIZE_COUNT; mask += SIZE_COUNT - 1) {
+    measure("malloc",       run_malloc,       mask);
+    measure("pb_malloc",    run_pb_malloc,    mask);
+    measure("pb_alloc_raw", run_pb_alloc_raw, mask);
+  }
+
+  return 0;
+
+} // main()
+// ==============================================================================
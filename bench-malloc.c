@@ -0,0 +1,739 @@
+// ==============================================================================
+/**
+ * bench-malloc.c
+ *
+ * A suite of microbenchmarks of the hot paths of `malloc()`, `calloc()`,
+ * `realloc()` and `free()`, for whichever allocator the program runs with:
+ * glibc's, one put in place with `LD_PRELOAD`, or libpb.so itself when built
+ * as `bench-malloc-pb`, which links against it.
+ *
+ *   bench-malloc [-s scenario] [-n ops] [-r reps] [-t threads] [-c cpu]
+ *                [-o text|csv|json] [-l label] [-u]
+ *
+ * Each scenario is run `reps` times untimed, for the nanoseconds per call,
+ * and once more with every call timed, for the percentiles of its latency.
+ * Every run is made in a child process of its own, pinned to a CPU, so that
+ * each starts from the same heap.  The threaded scenario is run with one
+ * thread, and then with twice as many each time, up to `threads`; since libpb
+ * is not thread-safe, it is skipped for an allocator that provides
+ * `pb_stats()`, unless `-u` is given.
+ *
+ * Around each untimed run, hardware and software counters are read with
+ * `perf_event_open()`: cycles, instructions, L1D, LLC and dTLB read misses,
+ * and page faults, reported per call.  A counter that cannot be opened (in a
+ * virtual machine, say, or under a strict `perf_event_paranoid`) is left out,
+ * and the rest are reported all the same.
+ *
+ * With `-o csv` or `-o json`, a line is printed per scenario, to be kept and
+ * compared across commits.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** The defaults: calls per run, untimed runs, and the most threads. */
+#define DEFAULT_OPS     200000
+#define DEFAULT_REPS    5
+#define DEFAULT_THREADS 4
+
+/** The most threads the threaded scenario may use. */
+#define MAX_THREADS 64
+
+/** The largest block of the random-size scenarios. */
+#define RANDOM_MAX 1024
+
+/** The blocks held at once by the LIFO scenario. */
+#define LIFO_DEPTH 16
+
+/** The size of each block of the large `calloc()` scenario. */
+#define CALLOC_SIZE (256 * 1024)
+
+/** The sizes between which each `realloc()` chain grows. */
+#define REALLOC_START 16
+#define REALLOC_LIMIT (64 * 1024)
+
+/** The counters read around each run. */
+#define COUNTERS 6
+
+/** The `perf_event_open()` configuration of a read miss in a cache. */
+#define READ_MISS(cache) ((cache)						\
+			  | (PERF_COUNT_HW_CACHE_OP_READ << 8)			\
+			  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** What one thread of a run measures, in memory shared with the parent. */
+typedef struct worker {
+
+  /** The thread's index, its scenario, and the calls it is to make. */
+  int      index;
+  size_t   (*run) (struct worker* worker);
+  size_t   ops;
+
+  /** Whether to time each call, and the latencies in ticks if so. */
+  bool     timed;
+  uint64_t max;
+  uint64_t histogram[BENCH_BUCKETS];
+
+  /** Where the thread keeps its blocks, and its random state. */
+  void**   blocks;
+  uint64_t random;
+
+} worker_s;
+
+/** A scenario: its name, and the body of each of its threads. */
+typedef struct scenario {
+
+  const char* name;
+  bool        threaded;
+
+  /** The fraction of `ops` that the scenario makes, so that the slower ones
+   *  finish in about the same time. */
+  size_t      divisor;
+
+  /** Run a thread, returning the calls it made. */
+  size_t      (*run) (worker_s* worker);
+
+} scenario_s;
+
+/** A counter: its name, and its `perf_event_open()` type and configuration. */
+typedef struct counter {
+
+  const char* name;
+  uint32_t    type;
+  uint64_t    config;
+
+} counter_s;
+
+/** What a run reports: its time and calls, and the count of each counter that
+ *  could be read. */
+typedef struct report {
+
+  uint64_t nanos;
+  uint64_t calls;
+  bool     ok;
+  uint64_t counts[COUNTERS];
+  bool     counted[COUNTERS];
+
+} report_s;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/** The CPU to which the first thread is pinned, and the CPUs there are. */
+static int      first_cpu     = 0;
+static int      cpu_count     = 1;
+
+/** What `bench_cycles()` costs, taken off each latency. */
+static uint64_t overhead      = 0;
+
+/** The counters, in the order they are reported. */
+static const counter_s counters[COUNTERS] = {
+  { "cycles",       PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES          },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS        },
+  { "l1d_misses",   PERF_TYPE_HW_CACHE, READ_MISS(PERF_COUNT_HW_CACHE_L1D)  },
+  { "llc_misses",   PERF_TYPE_HW_CACHE, READ_MISS(PERF_COUNT_HW_CACHE_LL)   },
+  { "dtlb_misses",  PERF_TYPE_HW_CACHE, READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+  { "page_faults",  PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS         }
+};
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time an allocator call if the worker is timing, recording its latency.
+ */
+#define TIMED(worker, call)						\
+  do {									\
+    if ((worker)->timed) {						\
+      uint64_t start_  = bench_cycles();				\
+      call;								\
+      uint64_t cycles_ = bench_cycles() - start_;			\
+      cycles_ = cycles_ > overhead ? cycles_ - overhead : 0;		\
+      (worker)->histogram[bench_bucket(cycles_)]++;			\
+      (worker)->max = cycles_ > (worker)->max ? cycles_ : (worker)->max; \
+    } else {								\
+      call;								\
+    }									\
+  } while (0)
+
+
+
+/** A random number from a worker's xorshift generator. */
+static inline uint64_t next_random (worker_s* worker) {
+
+  uint64_t x = worker->random;
+  x ^= x << 13;
+  x ^= x >> 7;
+  x ^= x << 17;
+  worker->random = x;
+  return x;
+
+} // next_random ()
+
+
+
+/** Write to a new block, as a program would. */
+static inline void touch (void* block) {
+
+  if (block != NULL) {
+    *(volatile char*)block = 1;
+  }
+
+} // touch ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+// SCENARIOS
+
+/** Allocate 64-byte blocks, then free them in the order allocated. */
+static size_t run_fixed (worker_s* worker) {
+
+  size_t count = worker->ops / 2;
+  for (size_t i = 0; i < count; i++) {
+    TIMED(worker, worker->blocks[i] = malloc(64));
+    touch(worker->blocks[i]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    TIMED(worker, free(worker->blocks[i]));
+  }
+  return 2 * count;
+
+} // run_fixed ()
+
+
+
+/** Allocate blocks of random sizes, then free them in the order allocated. */
+static size_t run_random (worker_s* worker) {
+
+  size_t count = worker->ops / 2;
+  for (size_t i = 0; i < count; i++) {
+    size_t size = 1 + next_random(worker) % RANDOM_MAX;
+    TIMED(worker, worker->blocks[i] = malloc(size));
+    touch(worker->blocks[i]);
+  }
+  for (size_t i = 0; i < count; i++) {
+    TIMED(worker, free(worker->blocks[i]));
+  }
+  return 2 * count;
+
+} // run_random ()
+
+
+
+/** Allocate a few blocks of random sizes and free them newest first, over and
+ *  over, as a program's temporaries come and go. */
+static size_t run_lifo (worker_s* worker) {
+
+  size_t rounds = worker->ops / (2 * LIFO_DEPTH);
+  for (size_t round = 0; round < rounds; round++) {
+    for (int i = 0; i < LIFO_DEPTH; i++) {
+      size_t size = 1 + next_random(worker) % RANDOM_MAX;
+      TIMED(worker, worker->blocks[i] = malloc(size));
+      touch(worker->blocks[i]);
+    }
+    for (int i = LIFO_DEPTH - 1; i >= 0; i--) {
+      TIMED(worker, free(worker->blocks[i]));
+    }
+  }
+  return rounds * 2 * LIFO_DEPTH;
+
+} // run_lifo ()
+
+
+
+/** Allocate large zeroed blocks, freeing each at once. */
+static size_t run_calloc (worker_s* worker) {
+
+  size_t count = worker->ops / 2;
+  for (size_t i = 0; i < count; i++) {
+    TIMED(worker, worker->blocks[0] = calloc(1, CALLOC_SIZE));
+    BENCH_KEEP(worker->blocks[0]);
+    TIMED(worker, free(worker->blocks[0]));
+  }
+  return 2 * count;
+
+} // run_calloc ()
+
+
+
+/** Grow blocks by half again with `realloc()` until they are large, as a
+ *  growing buffer does, and then free them. */
+static size_t run_realloc (worker_s* worker) {
+
+  size_t calls = 0;
+  while (calls < worker->ops) {
+    void* block = NULL;
+    for (size_t size = REALLOC_START; size <= REALLOC_LIMIT; size += size / 2) {
+      TIMED(worker, block = realloc(block, size));
+      touch(block);
+      calls++;
+    }
+    TIMED(worker, free(block));
+    calls++;
+  }
+  return calls;
+
+} // run_realloc ()
+
+
+
+/** The scenarios, in the order they are run. */
+static const scenario_s scenarios[] = {
+  { "fixed",   false, 1,  run_fixed   },
+  { "random",  false, 1,  run_random  },
+  { "lifo",    false, 1,  run_lifo    },
+  { "calloc",  false, 16, run_calloc  },
+  { "realloc", false, 1,  run_realloc },
+  { "threads", true,  1,  run_random  }
+};
+#define SCENARIO_COUNT (sizeof(scenarios) / sizeof(scenarios[0]))
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Pin the calling thread to a CPU.
+ *
+ * \param index The thread's index; threads are spread from `first_cpu` on.
+ */
+static void pin (int index) {
+
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+  CPU_SET((first_cpu + index) % cpu_count, &cpus);
+  pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+
+} // pin ()
+
+
+
+/** The body of each thread of a run. */
+static void* run_worker (void* arg) {
+
+  worker_s* worker = arg;
+  pin(worker->index);
+  return (void*)(uintptr_t)worker->run(worker);
+
+} // run_worker ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Open the counters for the calling process and the threads it goes on to
+ * create, disabled.  Those that cannot be opened are marked with -1.
+ *
+ * \param fds Where to put the counters' file descriptors.
+ * \return    The number of counters opened.
+ */
+static int open_counters (int fds[COUNTERS]) {
+
+  int opened = 0;
+  for (int i = 0; i < COUNTERS; i++) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size           = sizeof(attr);
+    attr.type           = counters[i].type;
+    attr.config         = counters[i].config;
+    attr.disabled       = 1;
+    attr.inherit        = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = (PERF_FORMAT_TOTAL_TIME_ENABLED
+			   | PERF_FORMAT_TOTAL_TIME_RUNNING);
+    fds[i]  = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    opened += fds[i] >= 0;
+  }
+  return opened;
+
+} // open_counters ()
+
+
+
+/** Start the counters that are open, from zero. */
+static void start_counters (const int fds[COUNTERS]) {
+
+  for (int i = 0; i < COUNTERS; i++) {
+    if (fds[i] >= 0) {
+      ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+      ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+} // start_counters ()
+
+
+
+/**
+ * Stop the counters that are open, and report them, scaled up for any time
+ * that the kernel had them multiplexed out.
+ */
+static void stop_counters (const int fds[COUNTERS], report_s* report) {
+
+  for (int i = 0; i < COUNTERS; i++) {
+    if (fds[i] >= 0) {
+      ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  for (int i = 0; i < COUNTERS; i++) {
+    uint64_t values[3];
+    if (fds[i] >= 0 && read(fds[i], values, sizeof(values)) == sizeof(values) &&
+	values[2] != 0) {
+      report->counts[i]  = (uint64_t)((double)values[0] * values[1] / values[2]);
+      report->counted[i] = true;
+    }
+  }
+
+} // stop_counters ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Run a scenario once, in a child process.
+ *
+ * \param scenario The scenario.
+ * \param threads  The threads to run it on.
+ * \param ops      The calls each thread is to make.
+ * \param workers  One worker per thread, in memory shared with the child.
+ * \param report   Where the child reports, likewise.
+ * \return         `true` if the child finished; `false` if not.
+ */
+static bool run_once (const scenario_s* scenario,
+		      int               threads,
+		      size_t            ops,
+		      worker_s*         workers,
+		      report_s*         report) {
+
+  memset(report, 0, sizeof(*report));
+  pid_t child = fork();
+  if (child < 0) {
+    return false;
+  }
+
+  if (child == 0) {
+    // Each thread's blocks are mapped rather than allocated, and in advance.
+    pthread_t handles[MAX_THREADS];
+    for (int i = 0; i < threads; i++) {
+      void** blocks = mmap(NULL, ops * sizeof(void*), PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+      if (blocks == MAP_FAILED) {
+	_exit(1);
+      }
+      workers[i].run     = scenario->run;
+      workers[i].blocks  = blocks;
+      workers[i].ops     = ops;
+      workers[i].index   = i;
+      workers[i].random  = 0x9e3779b97f4a7c15ULL * (i + 1);
+    }
+
+    int fds[COUNTERS];
+    open_counters(fds);
+    start_counters(fds);
+
+    uint64_t start = bench_nanos();
+    size_t   calls = 0;
+    if (threads == 1) {
+      calls = (size_t)(uintptr_t)run_worker(&workers[0]);
+    } else {
+      for (int i = 0; i < threads; i++) {
+	if (pthread_create(&handles[i], NULL, run_worker, &workers[i]) != 0) {
+	  _exit(1);
+	}
+      }
+      for (int i = 0; i < threads; i++) {
+	void* made;
+	pthread_join(handles[i], &made);
+	calls += (size_t)(uintptr_t)made;
+      }
+    }
+    report->nanos = bench_nanos() - start;
+    stop_counters(fds, report);
+    report->calls = calls;
+    report->ok    = true;
+    _exit(0);
+  }
+
+  int status;
+  while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0 && report->ok;
+
+} // run_once ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/** Order two doubles, for `qsort()`. */
+static int compare_doubles (const void* a, const void* b) {
+
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+
+} // compare_doubles ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Guess a label for the allocator in use: the library put in place with
+ * `LD_PRELOAD`, libpb if it is linked in, or else glibc.
+ */
+static const char* default_label () {
+
+  const char* preload = getenv("LD_PRELOAD");
+  if (preload != NULL && preload[0] != '\0') {
+    const char* slash = strrchr(preload, '/');
+    return slash != NULL ? slash + 1 : preload;
+  }
+  return dlsym(RTLD_DEFAULT, "pb_stats") != NULL ? "libpb.so" : "glibc";
+
+} // default_label ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  const char* only        = NULL;
+  const char* format      = "text";
+  const char* label       = NULL;
+  size_t      ops         = DEFAULT_OPS;
+  int         reps        = DEFAULT_REPS;
+  int         max_threads = DEFAULT_THREADS;
+  bool        unsafe      = false;
+  int         option;
+  while ((option = getopt(argc, argv, "s:n:r:t:c:o:l:u")) != -1) {
+    switch (option) {
+    case 's': only        = optarg;                       break;
+    case 'n': ops         = strtoull(optarg, NULL, 10);   break;
+    case 'r': reps        = atoi(optarg);                 break;
+    case 't': max_threads = atoi(optarg);                 break;
+    case 'c': first_cpu   = atoi(optarg);                 break;
+    case 'o': format      = optarg;                       break;
+    case 'l': label       = optarg;                       break;
+    case 'u': unsafe      = true;                         break;
+    default:
+      fprintf(stderr, "usage: %s [-s scenario] [-n ops] [-r reps] [-t threads]"
+	      " [-c cpu] [-o text|csv|json] [-l label] [-u]\n", argv[0]);
+      return 2;
+    }
+  }
+  if (ops < 2 * LIFO_DEPTH || reps < 1 || max_threads < 1 || max_threads > MAX_THREADS ||
+      (strcmp(format, "text") != 0 && strcmp(format, "csv") != 0 &&
+       strcmp(format, "json") != 0)) {
+    fprintf(stderr, "%s: bad option\n", argv[0]);
+    return 2;
+  }
+  label     = label != NULL ? label : default_label();
+  cpu_count = sysconf(_SC_NPROCESSORS_ONLN);
+  cpu_count = cpu_count > 0 ? cpu_count : 1;
+
+  bool   thread_safe = dlsym(RTLD_DEFAULT, "pb_stats") == NULL || unsafe;
+  double per_nano    = bench_cycles_per_nano();
+  overhead           = bench_overhead();
+
+  worker_s* workers = mmap(NULL, MAX_THREADS * sizeof(worker_s), PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  report_s* report  = mmap(NULL, sizeof(report_s), PROT_READ | PROT_WRITE,
+			   MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (workers == MAP_FAILED || report == MAP_FAILED) {
+    fprintf(stderr, "%s: cannot map shared memory\n", argv[0]);
+    return 1;
+  }
+  static uint64_t histogram[BENCH_BUCKETS];
+
+  // Say which counters cannot be read, once.
+  int fds[COUNTERS];
+  if (open_counters(fds) < COUNTERS) {
+    fprintf(stderr, "%s: cannot count", argv[0]);
+    for (int i = 0; i < COUNTERS; i++) {
+      if (fds[i] < 0) {
+	fprintf(stderr, " %s", counters[i].name);
+      }
+    }
+    fprintf(stderr, " (perf_event_open: %s)\n", strerror(errno));
+  }
+  for (int i = 0; i < COUNTERS; i++) {
+    if (fds[i] >= 0) {
+      close(fds[i]);
+    }
+  }
+
+  if (strcmp(format, "csv") == 0) {
+    printf("allocator,scenario,threads,calls,ns_per_call,min_ns_per_call,"
+	   "p50_ns,p90_ns,p99_ns,p999_ns,max_ns");
+    for (int i = 0; i < COUNTERS; i++) {
+      printf(",%s_per_call", counters[i].name);
+    }
+    printf("\n");
+  } else if (strcmp(format, "text") == 0) {
+    printf("%-16s %-8s %7s %9s %8s %8s %8s %8s %8s %8s %10s\n", "allocator",
+	   "scenario", "threads", "calls", "ns/call", "min", "p50", "p90",
+	   "p99", "p99.9", "max");
+  }
+
+  for (size_t s = 0; s < SCENARIO_COUNT; s++) {
+    const scenario_s* scenario = &scenarios[s];
+    if (only != NULL && strcmp(only, scenario->name) != 0) {
+      continue;
+    }
+    if (scenario->threaded && !thread_safe) {
+      if (strcmp(format, "text") == 0) {
+	printf("%-16s %-8s (skipped: libpb is not thread-safe; -u to run it)\n",
+	       label, scenario->name);
+      }
+      continue;
+    }
+
+    for (int threads = 1;
+	 threads <= (scenario->threaded ? max_threads : 1);
+	 threads *= 2) {
+      size_t calls_per_thread = ops / scenario->divisor;
+      double   nanos_per_call[reps];
+      bool     ok = true;
+      uint64_t counts[COUNTERS]  = { 0 };
+      bool     counted[COUNTERS];
+      uint64_t counted_calls     = 0;
+      memset(counted, true, sizeof(counted));
+
+      // The untimed runs, whose counters are summed.
+      for (int rep = 0; rep < reps && ok; rep++) {
+	memset(workers, 0, MAX_THREADS * sizeof(worker_s));
+	ok = run_once(scenario, threads, calls_per_thread, workers, report);
+	nanos_per_call[rep] = (double)report->nanos / (report->calls ? report->calls : 1);
+	for (int i = 0; i < COUNTERS; i++) {
+	  counts[i]  += report->counts[i];
+	  counted[i]  = counted[i] && report->counted[i];
+	}
+	counted_calls += report->calls;
+      }
+      double per_call[COUNTERS];
+      for (int i = 0; i < COUNTERS; i++) {
+	per_call[i] = (double)counts[i] / (counted_calls ? counted_calls : 1);
+      }
+
+      // The timed run, whose histograms are merged.
+      memset(workers, 0, MAX_THREADS * sizeof(worker_s));
+      for (int i = 0; i < threads; i++) {
+	workers[i].timed = true;
+      }
+      ok = ok && run_once(scenario, threads, calls_per_thread, workers, report);
+      if (!ok) {
+	fprintf(stderr, "%s: %s with %d thread%s failed\n", argv[0],
+		scenario->name, threads, threads == 1 ? "" : "s");
+	continue;
+      }
+      memset(histogram, 0, sizeof(histogram));
+      uint64_t max = 0;
+      for (int i = 0; i < threads; i++) {
+	for (unsigned int bucket = 0; bucket < BENCH_BUCKETS; bucket++) {
+	  histogram[bucket] += workers[i].histogram[bucket];
+	}
+	max = workers[i].max > max ? workers[i].max : max;
+      }
+
+      qsort(nanos_per_call, reps, sizeof(double), compare_doubles);
+      double median = nanos_per_call[reps / 2];
+      double least  = nanos_per_call[0];
+      double p50    = bench_percentile(histogram, 0.50)  / per_nano;
+      double p90    = bench_percentile(histogram, 0.90)  / per_nano;
+      double p99    = bench_percentile(histogram, 0.99)  / per_nano;
+      double p999   = bench_percentile(histogram, 0.999) / per_nano;
+      double worst  = max / per_nano;
+
+      if (strcmp(format, "csv") == 0) {
+	printf("%s,%s,%d,%lu,%.2f,%.2f,%.1f,%.1f,%.1f,%.1f,%.1f", label,
+	       scenario->name, threads, (unsigned long)report->calls, median,
+	       least, p50, p90, p99, p999, worst);
+	for (int i = 0; i < COUNTERS; i++) {
+	  if (counted[i]) {
+	    printf(",%.3f", per_call[i]);
+	  } else {
+	    printf(",");
+	  }
+	}
+	printf("\n");
+      } else if (strcmp(format, "json") == 0) {
+	printf("{\"allocator\":\"%s\",\"scenario\":\"%s\",\"threads\":%d,"
+	       "\"calls\":%lu,\"ns_per_call\":%.2f,\"min_ns_per_call\":%.2f,"
+	       "\"p50_ns\":%.1f,\"p90_ns\":%.1f,\"p99_ns\":%.1f,"
+	       "\"p999_ns\":%.1f,\"max_ns\":%.1f", label, scenario->name,
+	       threads, (unsigned long)report->calls, median, least, p50, p90,
+	       p99, p999, worst);
+	for (int i = 0; i < COUNTERS; i++) {
+	  if (counted[i]) {
+	    printf(",\"%s_per_call\":%.3f", counters[i].name, per_call[i]);
+	  } else {
+	    printf(",\"%s_per_call\":null", counters[i].name);
+	  }
+	}
+	printf("}\n");
+      } else {
+	printf("%-16s %-8s %7d %9lu %8.2f %8.2f %8.1f %8.1f %8.1f %8.1f %10.1f\n",
+	       label, scenario->name, threads, (unsigned long)report->calls,
+	       median, least, p50, p90, p99, p999, worst);
+	bool any = false;
+	for (int i = 0; i < COUNTERS; i++) {
+	  if (counted[i]) {
+	    printf("%s %s %.3f", any ? "," : "  per call:", counters[i].name, per_call[i]);
+	    any = true;
+	  }
+	}
+	if (any) {
+	  printf("\n");
+	}
+      }
+      fflush(stdout);
+    }
+  }
+
+  return 0;
+
+} // main()
+// ==============================================================================
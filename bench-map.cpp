@@ -0,0 +1,139 @@
+// ==============================================================================
+/**
+ * bench-map.cpp
+ *
+ * Map-building time with `pb::bump_allocator` versus `std::allocator` and a
+ * `std::pmr::polymorphic_allocator` over a monotonic buffer.  Each round builds
+ * a map, destroys it, and empties the arena or buffer.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <unordered_map>
+
+#include "bench.h"
+#include "pb-allocator.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Elements per map, and rounds per measurement. */
+static constexpr int elements = 200000;
+static constexpr int rounds   = 20;
+
+/** The size of the arena or buffer for the bump allocators. */
+static constexpr std::size_t capacity = std::size_t(128) << 20;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Build a map of `elements` pairs with the given allocator.
+ *
+ * \param allocator The allocator for the map.
+ */
+template <typename Map>
+static void build (typename Map::allocator_type allocator) {
+
+  Map values(allocator);
+  for (int i = 0; i < elements; i++) {
+    values.emplace((i * 7919) % elements, i);
+  }
+  BENCH_KEEP(values.size());
+
+} // build ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one map type, keeping the fastest round.
+ *
+ * \param map_name       The map's label.
+ * \param allocator_name The allocator's label.
+ * \param allocator      The allocator for the map.
+ * \param release        What to do after each round.
+ */
+template <typename Map>
+static void measure (const char*                   map_name,
+		     const char*                   allocator_name,
+		     typename Map::allocator_type  allocator,
+		     const std::function<void ()>& release) {
+
+  std::uint64_t best = UINT64_MAX;
+  for (int round = 0; round < rounds; round++) {
+    std::uint64_t start = bench_nanos();
+    build<Map>(allocator);
+    release();
+    std::uint64_t nanos = bench_nanos() - start;
+    best = nanos < best ? nanos : best;
+  }
+  std::printf("%-14s %-16s %8.3f ms\n", map_name, allocator_name, best / 1e6);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+using bump_pair     = pb::bump_allocator<std::pair<const int, int>>;
+
+using std_map       = std::map<int, int>;
+using bump_map      = std::map<int, int, std::less<int>, bump_pair>;
+using pmr_map       = std::pmr::map<int, int>;
+
+using std_hash_map  = std::unordered_map<int, int>;
+using bump_hash_map = std::unordered_map<int, int, std::hash<int>,
+					 std::equal_to<int>, bump_pair>;
+using pmr_hash_map  = std::pmr::unordered_map<int, int>;
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_arena_s arena;
+  if (!pb_arena_init(&arena, capacity)) {
+    std::fprintf(stderr, "Could not make an arena\n");
+    return 1;
+  }
+
+  // Give the monotonic resource a warm buffer of its own, like the arena.
+  static std::byte buffer[capacity];
+  std::fill(buffer, buffer + capacity, std::byte(0));
+  std::pmr::monotonic_buffer_resource monotonic(buffer, capacity);
+
+  auto reset_arena     = [&] { pb_arena_reset(&arena); };
+  auto reset_monotonic = [&] { monotonic.release(); };
+  auto nothing         = [] {};
+
+  measure<std_map>("map", "std::allocator", {}, nothing);
+  measure<bump_map>("map", "pb::bump", bump_pair(&arena), reset_arena);
+  measure<pmr_map>("map", "pmr::monotonic", &monotonic, reset_monotonic);
+
+  measure<std_hash_map>("unordered_map", "std::allocator", {}, nothing);
+  measure<bump_hash_map>("unordered_map", "pb::bump", bump_pair(&arena),
+			 reset_arena);
+  measure<pmr_hash_map>("unordered_map", "pmr::monotonic", &monotonic,
+			reset_monotonic);
+
+  pb_arena_destroy(&arena);
+  return 0;
+
+} // main()
+// ==============================================================================
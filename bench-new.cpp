@@ -0,0 +1,146 @@
+// ==============================================================================
+/**
+ * bench-new.cpp
+ *
+ * The cost of `new` and `delete` in workloads that do little else.  This
+ * program is not linked against any allocator; run it under `LD_PRELOAD` with
+ * `libpb.so` (which replaces only the C entry points) and with `libpbxx.so`
+ * (which also replaces `operator new` and `operator delete`) to compare them.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstdio>
+#include <list>
+#include <memory>
+#include <new>
+
+#include "bench.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Objects per round, and rounds per measurement. */
+static constexpr int objects = 1 << 12;
+static constexpr int rounds  = 2000;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The workloads, each allocating `objects` objects per round.
+
+/** A small object, as a node or a handle would be. */
+struct node_s {
+  node_s* next;
+  long    value;
+};
+
+/** An object aligned beyond what `operator new` guarantees by default. */
+struct alignas(64) line_s {
+  long value[8];
+};
+
+/** Each object deleted as soon as it is made, always at the top of the heap. */
+static void churn () {
+  for (int i = 0; i < objects; i++) {
+    node_s* node = new node_s{ nullptr, i };
+    BENCH_KEEP(node);
+    delete node;
+  }
+}
+
+/** A chain of objects, deleted in the reverse of the order they were made. */
+static void stack () {
+  node_s* top = nullptr;
+  for (int i = 0; i < objects; i++) {
+    top = new node_s{ top, i };
+  }
+  while (top != nullptr) {
+    node_s* next = top->next;
+    delete top;
+    top = next;
+  }
+}
+
+/** Arrays of assorted lengths, made and deleted in turn. */
+static void arrays () {
+  for (int i = 0; i < objects; i++) {
+    long* values = new long[1 + i % 32];
+    BENCH_KEEP(values);
+    delete[] values;
+  }
+}
+
+/** Over-aligned objects, made and deleted in turn. */
+static void aligned () {
+  for (int i = 0; i < objects; i++) {
+    line_s* line = new line_s;
+    BENCH_KEEP(line);
+    delete line;
+  }
+}
+
+/** A list built and then destroyed from the front. */
+static void list () {
+  std::list<int> values;
+  for (int i = 0; i < objects; i++) {
+    values.push_back(i);
+  }
+  BENCH_KEEP(values.size());
+}
+
+/** Shared pointers, each with its control block, made and dropped in turn. */
+static void shared () {
+  for (int i = 0; i < objects; i++) {
+    std::shared_ptr<node_s> node = std::make_shared<node_s>();
+    BENCH_KEEP(node.get());
+  }
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one workload, keeping the fastest round.
+ *
+ * \param name  The workload's label.
+ * \param build The workload.
+ */
+static void measure (const char* name, void (*build) ()) {
+
+  std::uint64_t best = UINT64_MAX;
+  for (int round = 0; round < rounds; round++) {
+    std::uint64_t start  = bench_cycles();
+    build();
+    std::uint64_t cycles = bench_cycles() - start;
+    best = cycles < best ? cycles : best;
+  }
+  std::printf("%-10s %7.2f cycles/object\n", name, (double)best / objects);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  measure("churn",   churn);
+  measure("stack",   stack);
+  measure("arrays",  arrays);
+  measure("aligned", aligned);
+  measure("list",    list);
+  measure("shared",  shared);
+  return 0;
+
+} // main()
+// ==============================================================================
@@ -0,0 +1,147 @@
+// ==============================================================================
+/**
+ * bench-pmr.cpp
+ *
+ * Container-building time with `pb::bump_resource` versus
+ * `std::pmr::monotonic_buffer_resource` and `std::pmr::new_delete_resource()`.
+ * Each round builds a container, destroys it, and releases the resource.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bench.h"
+#include "pb-resource.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Elements per container, and rounds per measurement. */
+static constexpr int elements = 100000;
+static constexpr int rounds   = 20;
+
+/** The size of the arena or initial buffer given to each resource. */
+static constexpr std::size_t capacity = std::size_t(64) << 20;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The workloads.
+
+static void build_vector (std::pmr::memory_resource* resource) {
+  std::pmr::vector<int> values(resource);
+  for (int i = 0; i < elements * 10; i++) {
+    values.push_back(i);
+  }
+  BENCH_KEEP(values.data());
+}
+
+static void build_map (std::pmr::memory_resource* resource) {
+  std::pmr::map<int, int> values(resource);
+  for (int i = 0; i < elements; i++) {
+    values.emplace((i * 7919) % elements, i);
+  }
+  BENCH_KEEP(values.size());
+}
+
+static void build_unordered_map (std::pmr::memory_resource* resource) {
+  std::pmr::unordered_map<int, std::pmr::string> values(resource);
+  for (int i = 0; i < elements; i++) {
+    values.emplace(i, std::pmr::string("a value too long for SSO", resource));
+  }
+  BENCH_KEEP(values.size());
+}
+
+static void build_strings (std::pmr::memory_resource* resource) {
+  std::pmr::vector<std::pmr::string> values(resource);
+  values.reserve(elements);
+  for (int i = 0; i < elements; i++) {
+    values.emplace_back(32 + i % 64, 'x');
+  }
+  BENCH_KEEP(values.data());
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one workload on one resource, keeping the fastest round.
+ *
+ * \param resource_name The resource's label.
+ * \param name          The workload's label.
+ * \param build         The workload.
+ * \param resource      The resource to build with.
+ * \param release       What to do with the resource after each round.
+ */
+template <typename Release>
+static void measure (const char*                resource_name,
+		     const char*                name,
+		     void (*build) (std::pmr::memory_resource*),
+		     std::pmr::memory_resource* resource,
+		     Release                    release) {
+
+  std::uint64_t best = UINT64_MAX;
+  for (int round = 0; round < rounds; round++) {
+    std::uint64_t start = bench_nanos();
+    build(resource);
+    release();
+    std::uint64_t nanos = bench_nanos() - start;
+    best = nanos < best ? nanos : best;
+  }
+  std::printf("%-22s %-10s %8.3f ms\n", name, resource_name, best / 1e6);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  struct {
+    const char* name;
+    void (*build) (std::pmr::memory_resource*);
+  } workloads[] = {
+    { "vector<int>",           build_vector        },
+    { "map<int,int>",          build_map           },
+    { "unordered_map<string>", build_unordered_map },
+    { "vector<string>",        build_strings       },
+  };
+
+  // Give the monotonic resource a buffer of its own, so that, like the pb
+  // arena, it reuses the same warm pages round after round.
+  static std::byte buffer[capacity];
+  std::fill(buffer, buffer + capacity, std::byte(0));
+
+  pb::bump_resource                   bump(capacity);
+  std::pmr::monotonic_buffer_resource monotonic(buffer, capacity);
+
+  for (auto& workload : workloads) {
+    measure("pb::bump", workload.name, workload.build,
+	    &bump, [&] { bump.release(); });
+    measure("monotonic", workload.name, workload.build,
+	    &monotonic, [&] { monotonic.release(); });
+    measure("new_delete", workload.name, workload.build,
+	    std::pmr::new_delete_resource(), [] {});
+  }
+
+  return 0;
+
+} // main()
+// ==============================================================================
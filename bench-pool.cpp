@@ -0,0 +1,139 @@
+// ==============================================================================
+/**
+ * bench-pool.cpp
+ *
+ * Churn through a working set of fixed-size objects with `pb::object_pool`
+ * versus `malloc()` and `free()`.  Each step frees a randomly chosen live
+ * object and allocates a replacement, so, unlike a LIFO pattern, nearly every
+ * freed block is buried beneath newer ones.
+ *
+ * This program is linked against libpb.so, so `malloc()` here is the bump
+ * allocator, which never reuses such blocks; glibc's allocator is called
+ * directly through `__libc_malloc()` and `__libc_free()`.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+#include "bench.h"
+#include "pb-pool.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Live objects, churn steps per round, and rounds per measurement. */
+static constexpr int live   = 1 << 10;
+static constexpr int steps  = 1 << 16;
+static constexpr int rounds = 50;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** A hot object, about the size of a timer or a connection's state. */
+struct connection_s {
+  std::uint64_t id;
+  std::uint64_t deadline;
+  void*         buffer;
+  connection_s* next;
+  int           fd;
+  int           state;
+};
+
+extern "C" void* __libc_malloc (std::size_t size);
+extern "C" void  __libc_free (void* ptr);
+// ==============================================================================
+
+
+
+// ==============================================================================
+// The contenders, each a pair of functions making and freeing one object.
+
+static pb::object_pool<connection_s> pool;
+
+static connection_s* pool_make (int i) { return pool.create(connection_s{ std::uint64_t(i) }); }
+static void          pool_drop (connection_s* c) { pool.destroy(c); }
+
+static connection_s* glibc_make (int i) {
+  auto* c = static_cast<connection_s*>(__libc_malloc(sizeof(connection_s)));
+  c->id = i;
+  return c;
+}
+static void glibc_drop (connection_s* c) { __libc_free(c); }
+
+static connection_s* pb_make (int i) {
+  auto* c = static_cast<connection_s*>(std::malloc(sizeof(connection_s)));
+  c->id = i;
+  return c;
+}
+static void pb_drop (connection_s* c) { std::free(c); }
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time one contender, keeping the fastest round.
+ *
+ * \param name The contender's label.
+ * \param make Allocate and initialize an object.
+ * \param drop Free an object.
+ */
+static void measure (const char*     name,
+		     connection_s* (*make) (int),
+		     void          (*drop) (connection_s*)) {
+
+  static connection_s* objects[live];
+
+  std::uint64_t best = UINT64_MAX;
+  for (int round = 0; round < rounds; round++) {
+    std::uint32_t random = 2463534242u;
+    for (int i = 0; i < live; i++) {
+      objects[i] = make(i);
+    }
+
+    std::uint64_t start = bench_cycles();
+    for (int i = 0; i < steps; i++) {
+      random ^= random << 13;
+      random ^= random >> 17;
+      random ^= random << 5;
+      int victim = random % live;
+      drop(objects[victim]);
+      objects[victim] = make(i);
+    }
+    std::uint64_t cycles = bench_cycles() - start;
+    best = cycles < best ? cycles : best;
+
+    for (int i = 0; i < live; i++) {
+      drop(objects[i]);
+    }
+  }
+  std::printf("%-14s %7.2f cycles/step\n", name, (double)best / steps);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  measure("object_pool", pool_make,  pool_drop);
+  measure("glibc malloc", glibc_make, glibc_drop);
+  measure("pb malloc",   pb_make,    pb_drop);
+  return 0;
+
+} // main()
+// ==============================================================================
@@ -0,0 +1,150 @@
+// ==============================================================================
+/**
+ * bench-stats.c
+ *
+ * The cost of `malloc()` and `free()` as called through the PLT, to be run
+ * under `LD_PRELOAD` with `libpb.so` and with `libpb-stats.so`,
+ * `libpb-trace.so` or `libpb-latency.so` to measure the overhead of the
+ * accounting, the tracing or the timing.  If the allocator provides
+ * `pb_stats()` or `pb_latency()`, the accounting or the latency histograms at
+ * the end of the run are printed too.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <dlfcn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** Blocks per round, and rounds per measurement. */
+#define ALLOCS (1 << 12)
+#define ROUNDS 2000
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/** Ticks of `bench_cycles()` per nanosecond. */
+static double per_nano;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Time `ALLOCS` allocations and then their frees in reverse order, which the
+ * bump allocator reclaims, so that every round starts from the same place.
+ * Report the fastest round of each, in cycles and in nanoseconds, and the
+ * mean, which includes the rare rounds that pay for something like a trace
+ * flush.
+ *
+ * \param name  The workload's label.
+ * \param mixed Whether to vary the sizes rather than use 32 bytes throughout.
+ */
+static void measure (const char* name, int mixed) {
+
+  static void* blocks[ALLOCS];
+
+  uint64_t best_malloc = UINT64_MAX;
+  uint64_t best_free   = UINT64_MAX;
+  uint64_t all_malloc  = 0;
+  uint64_t all_free    = 0;
+  for (int round = 0; round < ROUNDS; round++) {
+    uint64_t start = bench_cycles();
+    for (int i = 0; i < ALLOCS; i++) {
+      blocks[i] = malloc(mixed ? 1 + (i * 37) % 200 : 32);
+    }
+    uint64_t middle = bench_cycles();
+    for (int i = ALLOCS - 1; i >= 0; i--) {
+      free(blocks[i]);
+    }
+    uint64_t end = bench_cycles();
+
+    best_malloc = middle - start < best_malloc ? middle - start : best_malloc;
+    best_free   = end - middle   < best_free   ? end - middle   : best_free;
+    all_malloc += middle - start;
+    all_free   += end - middle;
+  }
+  printf("%-6s malloc %6.2f  free %6.2f cycles/call"
+	 " (%5.2f, %5.2f ns; mean %6.2f, %6.2f)\n", name,
+	 (double)best_malloc / ALLOCS, (double)best_free / ALLOCS,
+	 (double)best_malloc / ALLOCS / per_nano, (double)best_free / ALLOCS / per_nano,
+	 (double)all_malloc / ALLOCS / ROUNDS, (double)all_free / ALLOCS / ROUNDS);
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Print the allocator's accounting and latency histograms, if it has any.
+ */
+static void report (void) {
+
+  bool (*latency_fn) (pb_latency_s*) = (bool (*) (pb_latency_s*))dlsym(RTLD_DEFAULT,
+									  "pb_latency");
+  void (*dump_fn) (int) = (void (*) (int))dlsym(RTLD_DEFAULT, "pb_latency_dump");
+  static pb_latency_s latency;
+  if (latency_fn != NULL && dump_fn != NULL && latency_fn(&latency)) {
+    fflush(stdout);
+    dump_fn(STDOUT_FILENO);
+  }
+
+  bool (*stats_fn) (pb_stats_s*) = (bool (*) (pb_stats_s*))dlsym(RTLD_DEFAULT,
+								   "pb_stats");
+  pb_stats_s stats;
+  if (stats_fn == NULL || !stats_fn(&stats)) {
+    printf("(no accounting)\n");
+    return;
+  }
+
+  printf("in use %zu (raw %zu), peak %zu\n",
+	 stats.in_use, stats.raw_bytes, stats.peak);
+  printf("requested %zu, allocated %zu: headers %zu, padding %zu, dead %zu\n",
+	 stats.requested, stats.allocated, stats.header_bytes,
+	 stats.padding_bytes, stats.dead_bytes);
+  printf("calls: malloc %zu, free %zu, calloc %zu, realloc %zu\n",
+	 stats.malloc_calls, stats.free_calls, stats.calloc_calls,
+	 stats.realloc_calls);
+
+} // report ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  per_nano = bench_cycles_per_nano();
+  measure("fixed", 0);
+  measure("mixed", 1);
+
+  // Leave one dead block beneath a live one.
+  void* dead = malloc(100);
+  void* live = malloc(100);
+  BENCH_KEEP(dead);
+  free(dead);
+  BENCH_KEEP(live);
+
+  report();
+  return 0;
+
+} // main()
+// ==============================================================================
@@ -0,0 +1,201 @@
+// ==============================================================================
+/**
+ * bench.h
+ *
+ * Timing helpers shared by the benchmark programs.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_BENCH_H)
+#define _BENCH_H
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdint.h>
+#include <time.h>
+#if defined (__x86_64__) || defined (__i386__)
+#include <x86intrin.h>
+#endif
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** Keep the compiler from discarding a value that is otherwise unused. */
+#define BENCH_KEEP(value) __asm__ volatile ("" : : "r" (value))
+
+/**
+ * Latency histograms are log-linear: exact below `2 * BENCH_SUB_BUCKETS`, and
+ * in `BENCH_SUB_BUCKETS` steps per power of two above, so that every bucket
+ * is within about 3% of the values in it.
+ */
+#define BENCH_SUB_BITS    5
+#define BENCH_SUB_BUCKETS (1 << BENCH_SUB_BITS)
+#define BENCH_BUCKETS     (2 * BENCH_SUB_BUCKETS + (64 - BENCH_SUB_BITS - 1) * BENCH_SUB_BUCKETS)
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Read a cycle counter: the TSC where there is one, otherwise nanoseconds.
+ *
+ * \return The current count.
+ */
+static inline uint64_t bench_cycles (void) {
+
+#if defined (__x86_64__) || defined (__i386__)
+  _mm_lfence();
+  uint64_t now = __rdtsc();
+  _mm_lfence();
+  return now;
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+
+} // bench_cycles ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Read the monotonic clock.
+ *
+ * \return The current time, in nanoseconds.
+ */
+static inline uint64_t bench_nanos (void) {
+
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+
+} // bench_nanos ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Measure how many ticks of `bench_cycles()` there are per nanosecond, over a
+ * few milliseconds.
+ *
+ * \return The ratio.
+ */
+static inline double bench_cycles_per_nano (void) {
+
+  uint64_t nanos  = bench_nanos();
+  uint64_t cycles = bench_cycles();
+  while (bench_nanos() - nanos < 10000000) {
+  }
+  return (double)(bench_cycles() - cycles) / (bench_nanos() - nanos);
+
+} // bench_cycles_per_nano ()
+
+
+
+/**
+ * The least that `bench_cycles()` measures of nothing at all, to be taken off
+ * every latency measured with it.
+ *
+ * \return The overhead, in ticks.
+ */
+static inline uint64_t bench_overhead (void) {
+
+  uint64_t least = UINT64_MAX;
+  for (int i = 0; i < 1000; i++) {
+    uint64_t start  = bench_cycles();
+    uint64_t cycles = bench_cycles() - start;
+    least = cycles < least ? cycles : least;
+  }
+  return least;
+
+} // bench_overhead ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The histogram bucket for a latency.
+ *
+ * \param value The latency.
+ * \return      Its bucket, less than `BENCH_BUCKETS`.
+ */
+static inline unsigned int bench_bucket (uint64_t value) {
+
+  if (value < 2 * BENCH_SUB_BUCKETS) {
+    return value;
+  }
+  unsigned int exponent = 63 - __builtin_clzll(value);
+  return (2 * BENCH_SUB_BUCKETS + (exponent - BENCH_SUB_BITS - 1) * BENCH_SUB_BUCKETS
+	  + ((value >> (exponent - BENCH_SUB_BITS)) & (BENCH_SUB_BUCKETS - 1)));
+
+} // bench_bucket ()
+
+
+
+/**
+ * The smallest latency in a bucket.
+ *
+ * \param bucket The bucket.
+ * \return       The latency.
+ */
+static inline uint64_t bench_bucket_floor (unsigned int bucket) {
+
+  if (bucket < 2 * BENCH_SUB_BUCKETS) {
+    return bucket;
+  }
+  unsigned int exponent = (bucket - 2 * BENCH_SUB_BUCKETS) / BENCH_SUB_BUCKETS + BENCH_SUB_BITS + 1;
+  uint64_t     sub      = (bucket - 2 * BENCH_SUB_BUCKETS) % BENCH_SUB_BUCKETS;
+  return (1ULL << exponent) + (sub << (exponent - BENCH_SUB_BITS));
+
+} // bench_bucket_floor ()
+
+
+
+/**
+ * A percentile of a histogram.
+ *
+ * \param histogram The counts in each of `BENCH_BUCKETS` buckets.
+ * \param fraction  The percentile, as a fraction.
+ * \return          The floor of the bucket that holds it; zero if the
+ *                  histogram is empty.
+ */
+static inline uint64_t bench_percentile (const uint64_t* histogram, double fraction) {
+
+  uint64_t total = 0;
+  for (unsigned int bucket = 0; bucket < BENCH_BUCKETS; bucket++) {
+    total += histogram[bucket];
+  }
+  uint64_t rank = (uint64_t)(fraction * total);
+  uint64_t seen = 0;
+  for (unsigned int bucket = 0; bucket < BENCH_BUCKETS; bucket++) {
+    seen += histogram[bucket];
+    if (seen > rank) {
+      return bench_bucket_floor(bucket);
+    }
+  }
+  return 0;
+
+} // bench_percentile ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+#endif // _BENCH_H
+// ==============================================================================
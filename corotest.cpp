@@ -0,0 +1,160 @@
+// ==============================================================================
+/**
+ * corotest.cpp
+ *
+ * Check that coroutine frames bumped through `pb::arena_frames` are handed
+ * back exactly when destroyed in LIFO order: after each task, the arena's
+ * cursor must be back where it was before the task began, for frames of
+ * assorted sizes.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cassert>
+#include <coroutine>
+#include <cstdio>
+#include <exception>
+
+#include "pb-coroutine.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * A lazily started coroutine yielding an `int`, whose frame comes from the
+ * current `pb::frame_scope`.
+ */
+class task {
+
+public:
+
+  struct promise_type : pb::arena_frames {
+
+    int                     value = 0;
+    std::coroutine_handle<> continuation;
+
+    task get_return_object () noexcept {
+      return task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend () noexcept { return {}; }
+
+    struct final_awaiter {
+      bool await_ready () noexcept { return false; }
+      std::coroutine_handle<>
+      await_suspend (std::coroutine_handle<promise_type> self) noexcept {
+	return self.promise().continuation;
+      }
+      void await_resume () noexcept {}
+    };
+
+    final_awaiter final_suspend () noexcept { return {}; }
+
+    void return_value (int result) noexcept { value = result; }
+
+    void unhandled_exception () noexcept { std::terminate(); }
+
+  };
+
+  task (task&& other) noexcept
+    : handle_(other.handle_) {
+    other.handle_ = nullptr;
+  }
+
+  ~task () {
+    if (handle_) {
+      handle_.destroy();
+    }
+  }
+
+  bool await_ready () noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend (std::coroutine_handle<> caller) noexcept {
+    handle_.promise().continuation = caller;
+    return handle_;
+  }
+
+  int await_resume () noexcept { return handle_.promise().value; }
+
+  /** Run the task to completion from outside any coroutine. */
+  int run () {
+    handle_.promise().continuation = std::noop_coroutine();
+    handle_.resume();
+    return handle_.promise().value;
+  }
+
+private:
+
+  explicit task (std::coroutine_handle<promise_type> handle) noexcept
+    : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+
+}; // class task
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * A chain of `depth` nested `co_await`s, each frame carrying `N` bytes across
+ * its suspension so that the frames' sizes vary with `N`.
+ */
+template <int N>
+static task chain (int depth) {
+  volatile char pad[N];
+  pad[0] = (char)depth;
+  if (depth == 0) {
+    co_return 0;
+  }
+  int below = co_await chain<N>(depth - 1);
+  co_return below + 1 + (pad[0] != (char)depth);
+}
+
+/** Run chains of every depth up to `depth`, with frames from `arena`. */
+template <int N>
+static void check (pb_arena_s* arena, int depth) {
+
+  pb_mark_s start = pb_arena_mark(arena);
+  for (int i = 0; i <= depth; i++) {
+    int result = chain<N>(i).run();
+    assert(result == i);
+    assert(arena->free_addr == start.free_addr);  // every frame should have
+    assert(arena->end_addr  == start.end_addr);   // come back
+  }
+
+} // check ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_arena_s arena;
+  if (!pb_arena_init(&arena, 1 << 20)) {
+    std::fprintf(stderr, "Could not make an arena\n");
+    return 1;
+  }
+
+  {
+    pb::frame_scope scope(&arena);
+    check<1>(&arena, 64);
+    check<3>(&arena, 64);
+    check<9>(&arena, 64);
+    check<13>(&arena, 64);
+    check<41>(&arena, 64);
+    check<100>(&arena, 64);
+  }
+
+  pb_arena_destroy(&arena);
+  std::printf("corotest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================
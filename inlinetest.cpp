@@ -0,0 +1,138 @@
+// ==============================================================================
+/**
+ * inlinetest.cpp
+ *
+ * Check `pb::inline_arena`: that requests are served from the internal buffer
+ * until it is exhausted and from the fallback arena after, with the counters
+ * to match; that `owns()` tells the two apart right at the buffer's edges; and
+ * that blocks of odd sizes handed back in LIFO order, from either place, leave
+ * both arenas as they found them.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+
+#include "pb-inline-arena.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** The size of the internal buffer, and the odd sizes cycled through. */
+constexpr std::size_t capacity = 256;
+static const std::size_t sizes[] = { 1, 7, 13, 17, 31, 33 };
+constexpr std::size_t count = sizeof(sizes) / sizeof(sizes[0]);
+// ==============================================================================
+
+
+
+// ==============================================================================
+/** Check `owns()` on both sides of each edge of the buffer. */
+static void check_edges (pb::inline_arena<capacity>& arena, pb_arena_s* fallback) {
+
+  const char* start = arena.arena()->start_addr;
+  const char* limit = arena.arena()->limit_addr;
+  assert(limit - start == capacity);
+  assert(arena.owns(start));
+  assert(arena.owns(limit - 1));
+  assert(!arena.owns(limit));
+  assert(!arena.owns(start - 1));
+  assert(!arena.owns(fallback->start_addr));
+  assert(!arena.owns(nullptr));
+
+} // check_edges ()
+
+
+
+/**
+ * Allocate blocks of odd sizes until the buffer is exhausted and a few more
+ * go to the fallback, then hand them all back newest first.
+ */
+static void check_exhaustion (pb::inline_arena<capacity>& arena, pb_arena_s* fallback) {
+
+  pb_mark_s inside  = pb_arena_mark(arena.arena());
+  pb_mark_s outside = pb_arena_mark(fallback);
+  std::size_t inline_before   = arena.inline_count();
+  std::size_t fallback_before = arena.fallback_count();
+  std::size_t bytes_before    = arena.fallback_bytes();
+
+  void*       blocks[64];
+  std::size_t served = 0, spilled = 0, spilled_bytes = 0;
+  for (; served < 64 && spilled < 4; served++) {
+    std::size_t size = sizes[served % count];
+    blocks[served] = arena.allocate(size, 16);
+    assert(reinterpret_cast<std::uintptr_t>(blocks[served]) % 16 == 0);
+    if (arena.owns(blocks[served])) {
+      assert(spilled == 0);  // once the buffer is full, nothing more fits in it
+    } else {
+      const char* block = static_cast<const char*>(blocks[served]);
+      assert(block >= fallback->start_addr && block + size <= fallback->limit_addr);
+      spilled++;
+      spilled_bytes += size;
+    }
+  }
+  assert(spilled == 4);
+  assert(arena.inline_count()   - inline_before   == served - spilled);
+  assert(arena.fallback_count() - fallback_before == spilled);
+  assert(arena.fallback_bytes() - bytes_before    == spilled_bytes);
+
+  // A block larger than the whole buffer goes straight to the fallback.
+  void* large = arena.allocate(capacity + 1);
+  assert(!arena.owns(large));
+  arena.deallocate(large, capacity + 1);
+
+  while (served-- > 0) {
+    arena.deallocate(blocks[served], sizes[served % count]);
+  }
+  assert(arena.arena()->free_addr == inside.free_addr);    // every block should
+  assert(arena.arena()->end_addr  == inside.end_addr);     // have come back, to
+  assert(fallback->free_addr      == outside.free_addr);   // wherever it came
+  assert(fallback->end_addr       == outside.end_addr);    // from
+
+} // check_exhaustion ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_arena_s fallback;
+  if (!pb_arena_init(&fallback, 1 << 16)) {
+    std::fprintf(stderr, "Could not make a fallback arena\n");
+    return 1;
+  }
+
+  {
+    pb::inline_arena<capacity> arena(&fallback);
+    check_edges(arena, &fallback);
+    check_exhaustion(arena, &fallback);
+    check_exhaustion(arena, &fallback);
+    arena.reset();
+    check_exhaustion(arena, &fallback);
+  }
+
+  {
+    // The default fallback is the heap itself.
+    pb::inline_arena<capacity> arena;
+    assert(arena.fallback() == &pb_heap);
+    void* block = arena.allocate(capacity * 2);
+    assert(block != nullptr && !arena.owns(block));
+    arena.deallocate(block, capacity * 2);
+  }
+
+  pb_arena_destroy(&fallback);
+  std::printf("inlinetest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================
@@ -2,6 +2,7 @@
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define DBL_WORD_SIZE 16
 
@@ -49,8 +50,12 @@ int main (int argc, char **argv) {
   size_t new_sizes3[10] = {3, 75, 15, 19, 29, 36, 31, 47, 56, 47};
   for (int i = 0; i < 10; i++) {
     char* test3_old = malloc(old_sizes3[i]);
+    char  fill      = (char)('a' + i);
+    memset(test3_old, fill, old_sizes3[i]);
     char* test3_new = realloc(test3_old, new_sizes3[i]);
     assert(test3_new != test3_old);                             // pointer should change
-    assert(*test3_new == *test3_old);                           // contents should be copied over
+    for (size_t j = 0; j < old_sizes3[i]; j++) {
+      assert(test3_new[j] == fill);                             // contents should be copied over
+    }
   }
 }
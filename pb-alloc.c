@@ -4,6 +4,8 @@
  *
  * A _pointer-bumping_ heap allocator.  This allocator *does not re-use* freed
  * blocks.  It uses _pointer bumping_ to expand the heap with each allocation.
+ * Compile with `PB_BUMP_DOWN` to bump downward from the top of the heap rather
+ * than upward from the bottom.
  **/
 // ==============================================================================
 
@@ -12,15 +14,35 @@
 // ==============================================================================
 // INCLUDES
 
+/** `dladdr()`, with which the heap profiler and the site table name call
+ *  sites. */
+#if defined (PB_PROFILE) || defined (PB_SITES)
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
+#include <errno.h>
+#include <malloc.h>
+#include <math.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
 #include <unistd.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
 
+#include "pb-alloc.h"
+#include "pb-probe.h"
+#include "pb-shm.h"
+#include "pb-trace.h"
 #include "safeio.h"
 // ==============================================================================
 
@@ -45,19 +67,189 @@
 
 /** The virtual address space reserved for the heap. */
 #define HEAP_SIZE GB(2)
+
+/** The smallest chunk that a child arena carves from its parent. */
+#define MIN_CHUNK_SIZE KB(4)
+
+/** The pages whose residency is asked of `mincore()` at a time. */
+#define RESIDENCY_CHUNK_PAGES 4096
+
+/** Add to a field of the statistics page, with a store that is atomic but
+ *  imposes no ordering, in a build with `PB_STATS`; the allocator is the only
+ *  writer, so there is no need for an atomic read-modify-write. */
+#define STAT_ADD(page, field, amount)				\
+  __atomic_store_n(&(page)->field, (page)->field + (amount), __ATOMIC_RELAXED)
+
+/** Count a call to an entry point, in a build with `PB_STATS`. */
+#if defined (PB_STATS)
+#define COUNT_CALL(field) STAT_ADD(stats_page, stats.field, 1)
+#else
+#define COUNT_CALL(field) ((void)0)
+#endif /* PB_STATS */
+
+/** The records that the tracer holds before writing them to its spool, the
+ *  most that one event takes, and the bytes of encoded events that it writes at
+ *  a time at exit. */
+#define TRACE_RING_RECORDS  KB(64)
+#define TRACE_RING_SIZE     (TRACE_RING_RECORDS * sizeof(pb_trace_record_s))
+#define TRACE_EVENT_RECORDS 3
+#define TRACE_OUT_SIZE      KB(64)
+
+/**
+ * Bracket a call that one entry point makes to another (e.g., `realloc()` to
+ * `malloc()`), in a build with `PB_TRACE` or `PB_SITES`, so that only the
+ * outer call is traced, or counted at its call site.
+ */
+#if defined (PB_TRACE) || defined (PB_SITES)
+#define NEST()   (entry_depth++)
+#define UNNEST() (entry_depth--)
+#else
+#define NEST()   ((void)0)
+#define UNNEST() ((void)0)
+#endif /* PB_TRACE || PB_SITES */
+
+/** Record an event made by the caller of the entry point that uses this, in a
+ *  build with `PB_TRACE`. */
+#if defined (PB_TRACE)
+#define TRACE(op, size, addr, old)					\
+  trace_event((op), (size), (addr), (old), __builtin_return_address(0))
+#else
+#define TRACE(op, size, addr, old) ((void)0)
+#endif /* PB_TRACE */
+
+/** The environment variables that name the number of busiest call sites to
+ *  print at exit, and the signal on which to print them; and the call sites
+ *  that the table has room for, and the most that a dump will list. */
+#define SITES_ENV        "PB_SITES"
+#define SITES_SIGNAL_ENV "PB_SITES_SIGNAL"
+#define SITES_TABLE      1024
+#define SITES_TOP_MAX    256
+
+/** Count a call, and the bytes it asks for, at the call site of the entry
+ *  point that uses this, in a build with `PB_SITES`. */
+#if defined (PB_SITES)
+#define COUNT_SITE(size) count_site((uintptr_t)__builtin_return_address(0), (size))
+#else
+#define COUNT_SITE(size) ((void)0)
+#endif /* PB_SITES */
+
+/** The environment variables that set the period at which fast calls are
+ *  timed, and name the signal on which to print the latency histograms. */
+#define LATENCY_ENV        "PB_LATENCY"
+#define LATENCY_SIGNAL_ENV "PB_LATENCY_SIGNAL"
+
+/**
+ * Time a call to the entry point that uses this, in a build with `PB_LATENCY`.
+ * `LATENCY_SAMPLE()` starts the clock on one fast call in each period, and
+ * `LATENCY_START()` on a slow path if it is not already running; a call whose
+ * clock is running is recorded by `LATENCY_FAST()`, counting for the whole
+ * period, or by `LATENCY_SLOW()`, counting once.
+ */
+#if defined (PB_LATENCY)
+#define LATENCY_SAMPLE()        latency_sample()
+#define LATENCY_START(start)    ((start) != 0 ? (start) : latency_start())
+#define LATENCY_FAST(op, start) latency_record((op), (start), latencies.period)
+#define LATENCY_SLOW(op, start) latency_record((op), (start), 1)
+#else
+#define LATENCY_SAMPLE()        ((uint64_t)0)
+#define LATENCY_START(start)    (start)
+#define LATENCY_FAST(op, start) ((void)(start))
+#define LATENCY_SLOW(op, start) ((void)(start))
+#endif /* PB_LATENCY */
+
+/** The environment variables that name the file for the heap profile, set the
+ *  mean bytes allocated between samples, choose the profile's format, and name
+ *  the signal on which to write it; and the mean when none is given. */
+#define PROFILE_ENV        "PB_PROFILE_FILE"
+#define PROFILE_RATE_ENV   "PB_PROFILE_RATE"
+#define PROFILE_FORMAT_ENV "PB_PROFILE_FORMAT"
+#define PROFILE_SIGNAL_ENV "PB_PROFILE_SIGNAL"
+#define PROFILE_RATE       KB(512)
+
+/** The deepest stack that the heap profiler records; the call sites, and the
+ *  sampled blocks live at once, that it has room for; and the bytes of the
+ *  profile that it writes at a time. */
+#define PROFILE_DEPTH    32
+#define PROFILE_SITES    4096
+#define PROFILE_SAMPLES  KB(64)
+#define PROFILE_OUT_SIZE KB(16)
+
+/**
+ * Count a block against the bytes left until the next sample, and sample it if
+ * they run out; and forget a sampled block as it is freed, noting whether it
+ * was reclaimed.  Both do nothing unless built with `PB_PROFILE`.
+ */
+#if defined (PB_PROFILE)
+#define PROFILE_ALLOC(size, block)					\
+  do {									\
+    if (__builtin_expect((profile_countdown -= (int64_t)(size)) < 0, 0)) { \
+      profile_alloc((size), (block));					\
+    }									\
+  } while (0)
+#define PROFILE_FREE(ptr, size, reclaimed)				\
+  do {									\
+    if (profile_live != 0) {						\
+      profile_free((ptr), (size), (reclaimed));				\
+    }									\
+  } while (0)
+#else
+#define PROFILE_ALLOC(size, block)         ((void)0)
+#define PROFILE_FREE(ptr, size, reclaimed) ((void)0)
+#endif /* PB_PROFILE */
 // ==============================================================================
 
 
 // ==============================================================================
 // TYPES AND STRUCTURES
 
-/** A header for each block's metadata. */
-typedef struct header {
+/** A header for each block's metadata; see `pb-alloc.h`. */
+typedef pb_header_s header_s;
 
-  /** The size of the useful portion of the block, in bytes. */
-  size_t size;
-  
-} header_s;
+#if defined (PB_PROFILE)
+/**
+ * A call site in the heap profile: the stack that led to `malloc()`, innermost
+ * frame first, and the sampled blocks allocated there, those still live, and
+ * those freed but not reclaimed.  Each is counted in blocks, in their bytes,
+ * and in the bytes that the samples stand for.
+ */
+typedef struct profile_site {
+
+  uint64_t  hash;
+  uint32_t  depth;
+  uintptr_t pcs[PROFILE_DEPTH];
+
+  uint64_t  objects[3];
+  uint64_t  bytes[3];
+  uint64_t  estimate[3];
+
+} profile_site_s;
+
+/** The indices of those counts, in the order of the collapsed formats. */
+enum { PROFILE_ALLOCATED, PROFILE_LIVE, PROFILE_DEAD };
+
+/** A sampled block that is still live, and the bytes that it stands for. */
+typedef struct profile_sample {
+
+  uintptr_t addr;
+  uint32_t  site;
+  uint64_t  estimate;
+
+} profile_sample_s;
+#endif /* PB_PROFILE */
+
+/**
+ * The bookkeeping at the start of each chunk that a child arena carves from its
+ * parent.  It is a double word long, so the region after it stays aligned.
+ */
+typedef struct pb_chunk {
+
+  /** The chunk carved before this one, if any. */
+  struct pb_chunk* prev;
+
+  /** The number of bytes in the chunk, this bookkeeping included. */
+  size_t           size;
+
+} chunk_s;
 // ==============================================================================
 
 
@@ -65,233 +257,2890 @@ typedef struct header {
 // ==============================================================================
 // GLOBALS
 
-/** The address of the next available byte in the heap region. */
-static intptr_t free_addr  = 0;
+/** The cursors of the heap region; see `pb-alloc.h`. */
+pb_arena_s pb_heap = { NULL, NULL, NULL, NULL };
 
 /** The beginning of the heap. */
 static intptr_t start_addr = 0;
 
 /** The end of the heap. */
 static intptr_t end_addr   = 0;
+
+/** Where `mincore()` reports the residency of each page of a chunk. */
+static unsigned char residency[RESIDENCY_CHUNK_PAGES];
+
+#if defined (PB_STATS)
+/** The counted half of the accounting (see `pb_stats()`) lives in a statistics
+ *  page, which is a private one unless one is published in shared memory (see
+ *  `pb-shm.h`).  The allocator is not thread-safe, so it is the page's only
+ *  writer, and the counters need no merging. */
+static pb_shm_page_s  private_page;
+static pb_shm_page_s* stats_page = &private_page;
+
+/** The path of the published page, if any, and the process that made it. */
+static char           stats_path[64];
+static pid_t          stats_pid = 0;
+#endif /* PB_STATS */
+
+#if defined (PB_TRACE)
+/** The tracer's ring of records not yet written, `NULL` unless tracing, and
+ *  the number of records in it.  The allocator is not thread-safe, so one ring
+ *  serves the whole process, and it is flushed by whichever call fills it. */
+static pb_trace_record_s* trace_ring  = NULL;
+static size_t             trace_count = 0;
+
+/** The thread of the last event recorded. */
+static uint32_t           trace_last_tid = 0;
+
+/** The trace file, which holds the spool until it is encoded at exit, and its
+ *  path. */
+static int                trace_fd    = -1;
+static char               trace_path[4096];
+
+/** The buffer of encoded events on their way to the file. */
+static uint8_t            trace_out[TRACE_OUT_SIZE];
+
+/** Each thread's ID, read on its first event.  It lives in the initial TLS
+ *  block, so reading it neither calls into the dynamic linker nor allocates. */
+static __thread uint32_t trace_tid __attribute__((tls_model("initial-exec"))) = 0;
+#endif /* PB_TRACE */
+
+#if defined (PB_TRACE) || defined (PB_SITES)
+/** How deeply entry points are nested within one another. */
+static int               entry_depth = 0;
+#endif /* PB_TRACE || PB_SITES */
+
+#if defined (PB_SITES)
+/** The call sites of the entry points, a mapped table of fixed size addressed
+ *  by open addressing on the return address, `NULL` until the heap is
+ *  initialized; and the calls from sites that found it full.  The allocator
+ *  is the only writer, so relaxed stores suffice; they keep a dump from a
+ *  signal handler from reading a torn count. */
+static pb_site_s*        sites       = NULL;
+static pb_site_s         sites_full  = { 0, 0, 0 };
+
+/** The busiest sites to print at exit, if any. */
+static size_t            sites_top   = 0;
+
+/** Whether the sites are being printed from a signal handler, in which they
+ *  are not named with `dladdr()`, which is not async-signal-safe. */
+static bool              sites_in_signal = false;
+#endif /* PB_SITES */
+
+#if defined (PB_LATENCY)
+/** The latency histograms, whose period is zero unless they are kept, and the
+ *  fast calls left until the next one is timed.  The allocator is not
+ *  thread-safe, so one set of histograms serves the whole process, and there
+ *  is nothing to merge when they are read. */
+static pb_latency_s      latencies;
+static uint64_t          latency_countdown = UINT64_MAX;
+#endif /* PB_LATENCY */
+
+#if defined (PB_PROFILE)
+/** The bytes left to allocate before the next sample, and their mean, which
+ *  is zero unless profiling; and the state of the generator that draws them. */
+static int64_t           profile_countdown = INT64_MAX;
+static uint64_t          profile_rate      = 0;
+static uint64_t          profile_random    = 0;
+
+/** The call sites and the live sampled blocks, each a mapped table of fixed
+ *  size, addressed by open addressing; the entries in the latter; and the
+ *  samples dropped for want of room in either. */
+static profile_site_s*   profile_sites     = NULL;
+static profile_sample_s* profile_samples   = NULL;
+static size_t            profile_live      = 0;
+static uint64_t          profile_dropped   = 0;
+
+/** Where and how to write the profile at exit, if anywhere; and the buffer of
+ *  the profile on its way there. */
+static const char*       profile_path      = NULL;
+static int               profile_format    = PB_PROFILE_PPROF;
+static char              profile_out[PROFILE_OUT_SIZE];
+static size_t            profile_used      = 0;
+
+/** Whether the profile is being written from a signal handler, in which
+ *  frames are written as bare addresses rather than named with `dladdr()`,
+ *  which is not async-signal-safe. */
+static bool              profile_in_signal = false;
+
+/** The bounds of this library's code, whose frames are left off each stack;
+ *  and those of each thread's stack, found on its first sample, so that the
+ *  unwinder never follows a frame pointer outside it.  The allocator is not
+ *  thread-safe, so one profile serves the whole process. */
+static uintptr_t         profile_text_low  = 0;
+static uintptr_t         profile_text_high = 0;
+static __thread uintptr_t profile_stack_low  __attribute__((tls_model("initial-exec"))) = 0;
+static __thread uintptr_t profile_stack_high __attribute__((tls_model("initial-exec"))) = 0;
+#endif /* PB_PROFILE */
 // ==============================================================================
 
 
 
 // ==============================================================================
 /**
- * The initialization method.  If this is the first use of the heap, initialize it.
+ * Read the timestamp counter, or the monotonic clock where there is none.
+ *
+ * \return The current time, in ticks.
+ */
+static inline uint64_t tick_count () {
+
+#if defined (__x86_64__) || defined (__i386__)
+  return __builtin_ia32_rdtsc();
+#else
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+
+} // tick_count ()
+// ==============================================================================
+
+
+
+#if defined (PB_STATS)
+// ==============================================================================
+/**
+ * In a child process, go back to a private statistics page, so as not to write
+ * to the parent's.
  */
+static void unshare_stats_page () {
 
-void init () {
+  if (stats_page != &private_page) {
+    memcpy(&private_page, stats_page, sizeof(private_page));
+    stats_page = &private_page;
+  }
 
-  // Only do anything if there is no heap region (i.e., first time called).
-  if (start_addr == 0) {
+} // unshare_stats_page ()
+// ==============================================================================
 
-    DEBUG("Trying to initialize");
-    
-    // Allocate virtual address space in which the heap will reside. Make it
-    // un-shared and not backed by any file (_anonymous_ space).  A failure to
-    // map this space is fatal.
-    void* heap = mmap(NULL,
-		      HEAP_SIZE,
-		      PROT_READ | PROT_WRITE,
-		      MAP_PRIVATE | MAP_ANONYMOUS,
-		      -1,
-		      0);
-    if (heap == MAP_FAILED) {
-      ERROR("Could not mmap() heap region");
-    }
 
-    // Hold onto the boundaries of the heap as a whole.
-    start_addr = (intptr_t)heap;
-    end_addr   = start_addr + HEAP_SIZE;
-    free_addr  = start_addr;
 
-    // DEBUG: Emit a message to indicate that this allocator is being called.
-    DEBUG("bp-alloc initialized");
+// ==============================================================================
+/**
+ * If `PB_SHM_ENV` is set to `1`, move the statistics page into a file under
+ * `/dev/shm` named for this process, where `pbstat` can read it.  Any failure
+ * leaves the page private.  Nothing here allocates.
+ */
+static void publish_stats_page () {
 
+  const char* enabled = getenv(PB_SHM_ENV);
+  if (enabled == NULL || strcmp(enabled, "1") != 0) {
+    return;
   }
 
-} // init ()
+  // Append the process ID to the prefix, writing its digits backward.
+  pid_t  pid    = getpid();
+  size_t length = strlen(PB_SHM_PREFIX);
+  char   digits[16];
+  int    count  = 0;
+  memcpy(stats_path, PB_SHM_PREFIX, length);
+  for (pid_t rest = pid; rest != 0 || count == 0; rest /= 10) {
+    digits[count++] = '0' + rest % 10;
+  }
+  while (count > 0) {
+    stats_path[length++] = digits[--count];
+  }
+  stats_path[length] = '\0';
+
+  // /dev/shm is writable by everyone, so the page must be one this process
+  // made: clear away any stale one left by an earlier process with this ID,
+  // then create it afresh, never following a link, readable only by its owner.
+  // Should anything take the name in between, the page is not published.
+  unlink(stats_path);
+  int fd = open(stats_path, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC,
+		0600);
+  if (fd < 0) {
+    return;
+  }
+  void* shared = MAP_FAILED;
+  if (ftruncate(fd, sizeof(pb_shm_page_s)) == 0) {
+    shared = mmap(NULL, sizeof(pb_shm_page_s), PROT_READ | PROT_WRITE,
+		  MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (shared == MAP_FAILED) {
+    unlink(stats_path);
+    return;
+  }
+
+  pb_shm_page_s* page = shared;
+  memcpy(page, &private_page, sizeof(*page));
+  page->version    = PB_SHM_VERSION;
+  page->pid        = pid;
+  page->start_addr = pb_heap.start_addr;
+  page->limit_addr = pb_heap.limit_addr;
+  page->free_addr  = pb_heap.free_addr;
+  page->end_addr   = pb_heap.end_addr;
+  __atomic_store_n(&page->magic, PB_SHM_MAGIC, __ATOMIC_RELEASE);
+
+  stats_page = page;
+  stats_pid  = pid;
+  pthread_atfork(NULL, NULL, unshare_stats_page);
+
+} // publish_stats_page ()
 // ==============================================================================
 
 
+
 // ==============================================================================
 /**
- * Allocate and return `size` bytes of heap space.  Expand into the heap region
- * via _pointer bumping_.
+ * Remove the published statistics page as the process exits.
+ */
+__attribute__((destructor))
+static void retract_stats_page () {
+
+  if (stats_pid != 0 && stats_pid == getpid()) {
+    unlink(stats_path);
+  }
+
+} // retract_stats_page ()
+// ==============================================================================
+#endif /* PB_STATS */
+
+
+
+#if defined (PB_TRACE)
+// ==============================================================================
+/**
+ * Write all of a buffer to `fd`, giving up if it cannot.
  *
- * \param size The number of bytes to allocate.
+ * \param fd     The file to write.
+ * \param buffer The bytes to write.
+ * \param length The number of bytes.
+ * \return       `true` if successful; `false` if not.
+ */
+static bool trace_write (int fd, const void* buffer, size_t length) {
+
+  const char* next = buffer;
+  while (length > 0) {
+    ssize_t written = write(fd, next, length);
+    if (written > 0) {
+      next   += written;
+      length -= written;
+    } else if (written < 0 && errno != EINTR) {
+      return false;
+    }
+  }
+  return true;
 
- * \return A pointer to the allocated block, if successful; `NULL` if
- *         unsuccessful.
+} // trace_write ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Record a clock event, which ties the timestamp counter to the monotonic
+ * clock.  One begins each flush of the ring.
  */
-void* malloc (size_t size) {
-  
-  /** Ensure that the heap is initialized. */
-  init();
+static void trace_clock () {
 
-  /** Ensure that the pointer that gets returned is double-word aligned. 
-   *  Specifically, free_addr should be sizeof(header_s) away from a
-   *  double-word boundary, so that after the header is put in place, the 
-   *  usable block is aligned appropriately. */
-  intptr_t padding = (sizeof(header_s) + DBL_WORD_SIZE - (free_addr % DBL_WORD_SIZE)) % DBL_WORD_SIZE; 
-  free_addr += padding;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  pb_trace_record_s* clock = &trace_ring[trace_count++];
+  clock->tsc   = tick_count();
+  clock->size  = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+  clock->addr  = 0;
+  clock->pc_op = (uint64_t)PB_TRACE_CLOCK << PB_TRACE_OP_SHIFT;
 
-  /** If trying to allocate a block of zero length, return a null pointer. */
-  if (size == 0) {
-    return NULL;
+} // trace_clock ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Append the records in the ring to the spool as they are, with no encoding,
+ * and begin the ring again with a clock event.  If the spool cannot be
+ * written, tracing stops with what it holds.  Nothing here allocates.
+ */
+__attribute__((noinline, cold))
+static void trace_flush () {
+
+  size_t length = trace_count * sizeof(pb_trace_record_s);
+  if (!trace_write(trace_fd, trace_ring, length)) {
+    close(trace_fd);
+    munmap(trace_ring, TRACE_RING_SIZE);
+    trace_fd   = -1;
+    trace_ring = NULL;
+    return;
   }
+  trace_count = 0;
+  trace_clock();
 
-  /** When allocating memory in the heap, ensure we add on some extra space
-   *  for the header, besides what the program is requesting. */
-  size_t    total_size = size + sizeof(header_s);
+} // trace_flush ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Record an event in the ring, flushing it first if it is full.  Calls nested
+ * within another entry point are not recorded, and nothing is unless tracing.
+ *
+ * \param op   The operation.
+ * \param size The number of bytes requested.
+ * \param addr The block returned or freed.
+ * \param old  For `realloc()`, the block passed in.
+ * \param pc   The caller's return address.
+ */
+static inline void trace_event (pb_trace_op_e op,
+				size_t        size,
+				void*         addr,
+				void*         old,
+				void*         pc) {
+
+  if (__builtin_expect(trace_ring == NULL || entry_depth != 0, 1)) {
+    return;
+  }
+  if (__builtin_expect(trace_count > (TRACE_RING_RECORDS
+				     - TRACE_EVENT_RECORDS), 0)) {
+    trace_flush();
+    if (trace_ring == NULL) {
+      return;
+    }
+  }
 
-  /** header_ptr gets a pointer to the first free address in the heap, where
-   *  the header will be located. */
-  header_s* header_ptr = (header_s*)free_addr;
+  // A record of the thread precedes the first event of each run from one.
+  uint32_t tid = trace_tid != 0 ? trace_tid : (trace_tid = syscall(SYS_gettid));
+  if (__builtin_expect(tid != trace_last_tid, 0)) {
+    pb_trace_record_s* thread = &trace_ring[trace_count++];
+    thread->tsc    = 0;
+    thread->size   = tid;
+    thread->addr   = 0;
+    thread->pc_op  = (uint64_t)PB_TRACE_THREAD << PB_TRACE_OP_SHIFT;
+    trace_last_tid = tid;
+  }
 
-  /** block_ptr gets a generic (void*) pointer to the first address of the 
-   *  block of memory being allocated. This address comes right after the
-   *  header, so we are adding the size of the header to the first free address
-   *  in order to find the address of the actual allocated space. */
-  void*     block_ptr  = (void*)(free_addr + sizeof(header_s));
+  pb_trace_record_s* event = &trace_ring[trace_count++];
+  event->tsc   = tick_count();
+  event->size  = size;
+  event->addr  = (uintptr_t)addr;
+  event->pc_op = (uintptr_t)pc | (uint64_t)op << PB_TRACE_OP_SHIFT;
+
+  // A record of the old block follows that of a realloc().
+  if (op == PB_TRACE_REALLOC) {
+    pb_trace_record_s* moved = &trace_ring[trace_count++];
+    moved->tsc   = 0;
+    moved->size  = 0;
+    moved->addr  = (uintptr_t)old;
+    moved->pc_op = (uint64_t)PB_TRACE_OLD << PB_TRACE_OP_SHIFT;
+  }
 
-  /** new_free_address is where the first free address pointer would point to 
-   *  after the allocation. It is basically a translation of free_addr by the
-   *  total size of the allocated block (header + space to be used by the 
-   *  program). */
-  intptr_t new_free_addr = free_addr + total_size;
+} // trace_event ()
+// ==============================================================================
 
-  /** Have we exceeded the maximum size of the heap? */
-  if (new_free_addr > end_addr) {
 
-    /** If yes, then return a null pointer - allocation failed. */
-    return NULL;
 
-  } else {
+// ==============================================================================
+/**
+ * Encode the spool at `trace_path` into a file beside it, and put that in its
+ * place.  If anything fails, the spool is left as it is, for the reader to
+ * encode.
+ */
+static void trace_encode () {
 
-    /** If not, then the first free address gets updated accordingly. */
-    free_addr = new_free_addr;
+  char   temp[sizeof(trace_path) + sizeof(".encode")];
+  size_t length = strlen(trace_path);
+  memcpy(temp, trace_path, length);
+  memcpy(temp + length, ".encode", sizeof(".encode"));
 
+  int         spool_fd = open(trace_path, O_RDONLY | O_CLOEXEC);
+  struct stat info;
+  if (spool_fd < 0) {
+    return;
+  }
+  if (fstat(spool_fd, &info) != 0 || info.st_size == 0) {
+    close(spool_fd);
+    return;
+  }
+  const pb_trace_record_s* spool = mmap(NULL, info.st_size, PROT_READ,
+					MAP_PRIVATE, spool_fd, 0);
+  close(spool_fd);
+  if (spool == MAP_FAILED) {
+    return;
+  }
+  madvise((void*)spool, info.st_size, MADV_SEQUENTIAL);
+
+  int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd >= 0) {
+    pb_trace_header_s header = *(const pb_trace_header_s*)spool;
+    header.magic = PB_TRACE_MAGIC;
+
+    pb_trace_event_s prev  = { 0 };
+    pb_trace_event_s event = { 0 };
+    size_t           count = info.st_size / sizeof(pb_trace_record_s);
+    size_t           next  = 1;
+    uint8_t*         out   = trace_out;
+    bool             ok    = trace_write(fd, &header, sizeof(header));
+    while (ok && pb_trace_unspool(spool, count, &next, &event)) {
+      if (out + PB_TRACE_MAX_EVENT_SIZE > trace_out + TRACE_OUT_SIZE) {
+	ok  = trace_write(fd, trace_out, out - trace_out);
+	out = trace_out;
+      }
+      out = pb_trace_encode(out, &prev, &event);
+    }
+    ok = ok && trace_write(fd, trace_out, out - trace_out);
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp, trace_path) != 0) {
+      unlink(temp);
+    }
   }
+  munmap((void*)spool, info.st_size);
 
-  /** Write the size of the allocated block to that block's header. Note that
-   *  this is the size of the actual usable part, not the total size. */
-  header_ptr->size = size;
-  
-  /** Return a pointer to the first address of the program-usable part of the 
-   *  allocated space - allocation succeeded. */
-  return block_ptr;
+} // trace_encode ()
+// ==============================================================================
 
-} // malloc()
+
+
+// ==============================================================================
+/**
+ * Stop tracing as the process exits, and encode what was recorded.
+ */
+__attribute__((destructor))
+static void stop_trace () {
+
+  if (trace_ring != NULL) {
+    trace_flush();
+  }
+  if (trace_ring != NULL) {
+    close(trace_fd);
+    munmap(trace_ring, TRACE_RING_SIZE);
+    trace_fd   = -1;
+    trace_ring = NULL;
+    trace_encode();
+  }
+
+} // stop_trace ()
+
+
+
+/**
+ * Stop tracing in a child process, without flushing, since the events in the
+ * ring are the parent's to write, as is the spool to encode.
+ */
+static void abandon_trace () {
+
+  if (trace_ring != NULL) {
+    munmap(trace_ring, TRACE_RING_SIZE);
+    close(trace_fd);
+    trace_fd    = -1;
+    trace_ring  = NULL;
+    trace_count = 0;
+  }
+
+} // abandon_trace ()
 // ==============================================================================
 
 
 
 // ==============================================================================
 /**
- * Deallocate a given block on the heap.  Add the given block (if any) to the
- * free list.
- *
- * \param ptr A pointer to the block to be deallocated.
+ * If `PB_TRACE_ENV` names a file, begin tracing into it: map the ring, and put
+ * the spool's header in the first slot.  Any failure leaves tracing off.
+ * Nothing here allocates.
  */
-void free (void* ptr) {
+static void start_trace () {
 
-  DEBUG("free(): ", (intptr_t)ptr);
+  const char* path = getenv(PB_TRACE_ENV);
+  if (path == NULL || path[0] == '\0' || strlen(path) >= sizeof(trace_path)) {
+    return;
+  }
+  strcpy(trace_path, path);
 
-} // free()
+  void* ring = mmap(NULL, TRACE_RING_SIZE, PROT_READ | PROT_WRITE,
+		    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (ring == MAP_FAILED) {
+    return;
+  }
+  trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (trace_fd < 0) {
+    munmap(ring, TRACE_RING_SIZE);
+    return;
+  }
+  trace_ring  = ring;
+  trace_count = 0;
+
+  // The header takes the slot of the first record.
+  trace_last_tid = 0;
+  pb_trace_header_s* header = (pb_trace_header_s*)&trace_ring[trace_count++];
+  header->magic      = PB_TRACE_SPOOL_MAGIC;
+  header->version    = PB_TRACE_VERSION;
+  header->pid        = getpid();
+  header->heap_start = (uintptr_t)pb_heap.start_addr;
+  header->heap_limit = (uintptr_t)pb_heap.limit_addr;
+  trace_clock();
+
+  pthread_atfork(NULL, NULL, abandon_trace);
+
+} // start_trace ()
 // ==============================================================================
+#endif /* PB_TRACE */
 
 
 
+#if defined (PB_LATENCY)
 // ==============================================================================
 /**
- * Allocate a block of `nmemb * size` bytes on the heap, zeroing its contents.
+ * Decide whether to time a call on a fast path, which is one in each period.
  *
- * \param nmemb The number of elements in the new block.
- * \param size  The size, in bytes, of each of the `nmemb` elements.
- * \return      A pointer to the newly allocated and zeroed block, if successful;
- *              `NULL` if unsuccessful.
+ * \return The time, if the call is to be timed; zero if not.
  */
-void* calloc (size_t nmemb, size_t size) {
+static inline uint64_t latency_sample () {
 
-  // Allocate a block of the requested size.
-  size_t block_size = nmemb * size;
-  void*  block_ptr  = malloc(block_size);
+  if (__builtin_expect(--latency_countdown != 0, 1)) {
+    return 0;
+  }
+  latency_countdown = latencies.period != 0 ? latencies.period : UINT64_MAX;
+  return latencies.period != 0 ? tick_count() : 0;
 
-  // If the allocation succeeded, clear the entire block.
-  if (block_ptr != NULL) {
-    memset(block_ptr, 0, block_size);
+} // latency_sample ()
+
+
+
+/**
+ * Start timing a call on a slow path, all of which are timed.
+ *
+ * \return The time, if the histograms are kept; zero if not.
+ */
+static inline uint64_t latency_start () {
+
+  return latencies.period != 0 ? tick_count() : 0;
+
+} // latency_start ()
+
+
+
+/**
+ * Record a call in its entry point's histogram, if it was timed.
+ *
+ * \param op     The entry point.
+ * \param start  The time at which the call began, or zero if it was not timed.
+ * \param weight The calls that this one stands for.
+ */
+static inline void latency_record (pb_latency_op_e op, uint64_t start, uint64_t weight) {
+
+  if (__builtin_expect(start == 0, 1)) {
+    return;
+  }
+  uint64_t ticks = tick_count() - start;
+  latencies.histogram[op][pb_latency_bucket(ticks)] += weight;
+  latencies.timed[op]++;
+  if (ticks > latencies.max[op]) {
+    latencies.max[op] = ticks;
   }
 
-  return block_ptr;
-  
-} // calloc ()
+} // latency_record ()
 // ==============================================================================
 
 
 
 // ==============================================================================
 /**
- * Update the given block at `ptr` to take on the given `size`.  Here, if `size`
- * fits within the given block, then the block is returned unchanged.  If the
- * `size` is an increase for the block, then a new and larger block is
- * allocated, and the data from the old block is copied, the old block freed,
- * and the new block returned.
+ * Print the latency histograms on the signal named by `LATENCY_SIGNAL_ENV`.
  *
- * \param ptr  The block to be assigned a new size.
- * \param size The new size that the block should assume.
- * \return     A pointer to the resultant block, which may be `ptr` itself, or
- *             may be a newly allocated block.
+ * \param signo The signal.
  */
-void* realloc (void* ptr, size_t size) {
+static void latency_signal (int signo) {
 
-  /** If passed in a null pointer, then presumably there's no pre-existent
-   *  block. As such, call malloc to allocate a new one of the desired size. */
-  if (ptr == NULL) {
-    return malloc(size);
-  }
+  int saved_errno = errno;
+  pb_latency_dump(STDERR_FILENO);
+  errno = saved_errno;
 
-  /** If passed a new size of 0, this is basically the same as freeing the
-   *  block. So call free and return a null pointer. */
-  if (size == 0) {
-    free(ptr);
-    return NULL;
+} // latency_signal ()
+
+
+
+/**
+ * If `LATENCY_ENV` gives a period, begin keeping the latency histograms, and
+ * if `LATENCY_SIGNAL_ENV` names a signal, print them whenever it arrives.
+ * Nothing here allocates.
+ */
+static void start_latency () {
+
+  const char* period = getenv(LATENCY_ENV);
+  if (period == NULL || strtoull(period, NULL, 10) == 0) {
+    return;
+  }
+  latencies.period  = strtoull(period, NULL, 10);
+  latency_countdown = latencies.period;
+
+  const char* signo = getenv(LATENCY_SIGNAL_ENV);
+  if (signo != NULL && atoi(signo) > 0) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = latency_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(atoi(signo), &action, NULL);
   }
 
-  /** old_header gets the address of the header of the old (i.e. un-reallocated)
-   *  block of memory. This is done by walking backwards from the block pointer
-   *  a number of bytes equal to the known header size. */
-  header_s* old_header = (header_s*)((intptr_t)ptr - sizeof(header_s));
+} // start_latency ()
+// ==============================================================================
+#endif /* PB_LATENCY */
 
-  /** Read in the size of the old block of memory from the old header. */
-  size_t    old_size   = old_header->size;
 
-  /** If the new size the program asks for is less than or equal to the old
-   *  size, simply return the old pointer - there's enough space in the current
-   *  block already. */
-  if (size <= old_size) {
-    return ptr;
+
+#if defined (PB_PROFILE)
+// ==============================================================================
+/**
+ * Find the mapping that holds an address, by reading `/proc/self/maps` a
+ * buffer at a time, without allocating.
+ *
+ * \param addr The address.
+ * \param low  Where to put the start of its mapping.
+ * \param high Where to put the end of its mapping.
+ * \return     `true` if the mapping was found; `false` if not.
+ */
+static bool find_mapping (uintptr_t addr, uintptr_t* low, uintptr_t* high) {
+
+  int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
   }
 
-  /** Otherwise (i.e. if the program is asking for a bigger size than the 
-   *  old one), call malloc to allocate a new block of that size somewhere
-   *  else that might be available. */
-  void* new_ptr = malloc(size);
+  char    buffer[KB(4)];
+  size_t  kept  = 0;
+  bool    found = false;
+  ssize_t got;
+  while (!found && (got = read(fd, buffer + kept, sizeof(buffer) - kept)) > 0) {
+    char* line = buffer;
+    char* end  = buffer + kept + got;
+    char* newline;
+    while (!found && (newline = memchr(line, '\n', end - line)) != NULL) {
+      char*     dash  = NULL;
+      uintptr_t start = strtoull(line, &dash, 16);
+      uintptr_t stop  = *dash == '-' ? strtoull(dash + 1, NULL, 16) : 0;
+      if (start <= addr && addr < stop) {
+	*low  = start;
+	*high = stop;
+	found = true;
+      }
+      line = newline + 1;
+    }
 
-  /** If the allocation succeeded (i.e. the pointer returned by malloc is not
-   *  null), then copy all the contents of the old block into the new block,
-   *  and free the old block. */
-  if (new_ptr != NULL) {
-    memcpy(new_ptr, ptr, old_size);
-    free(ptr);
+    // Carry a partial line over to the next read; a line longer than the
+    // buffer cannot be a mapping's bounds, and is dropped.
+    kept = end - line < (ptrdiff_t)sizeof(buffer) ? end - line : 0;
+    memmove(buffer, line, kept);
   }
+  close(fd);
+  return found;
 
-  /** Return a pointer to the newly allocated block of memory. */
-  return new_ptr;
-  
-} // realloc()
+} // find_mapping ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Draw the bytes to allocate before the next sample, which are exponentially
+ * distributed about `profile_rate`, so that each byte is equally likely to be
+ * sampled whatever the sizes of the blocks around it.
+ *
+ * \return The bytes, at least one.
+ */
+static int64_t profile_interval () {
+
+  // xorshift64*, and a uniform draw from (0, 1] made of its top 53 bits.
+  profile_random ^= profile_random >> 12;
+  profile_random ^= profile_random << 25;
+  profile_random ^= profile_random >> 27;
+  double uniform = (double)(((profile_random * 0x2545f4914f6cdd1dULL) >> 11) + 1) / 0x1p53;
+  double bytes   = -log(uniform) * profile_rate;
+  return bytes < 1 ? 1 : bytes > INT64_MAX / 2 ? INT64_MAX / 2 : (int64_t)bytes;
+
+} // profile_interval ()
+
+
+
+/**
+ * The bytes that a sampled block stands for: sampling by bytes takes a block
+ * of `size` bytes with probability `1 - exp(-size / rate)`, so each sample
+ * stands for `size` divided by that.
+ *
+ * \param size The block's size.
+ * \return     The bytes.
+ */
+static uint64_t profile_estimate (size_t size) {
+
+  return (uint64_t)(size / -expm1(-(double)size / profile_rate));
+
+} // profile_estimate ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Walk the frame pointers from here up the stack, recording the return address
+ * of each frame and leaving off those within this library.  A frame pointer is
+ * followed only while it climbs, aligned, within the thread's stack, so a
+ * caller built without frame pointers cuts the stack short rather than leading
+ * the walk astray.  Nothing here allocates.
+ *
+ * \param pcs Where to put the return addresses, innermost first.
+ * \return    The number of them.
+ */
+__attribute__((noinline))
+static uint32_t profile_unwind (uintptr_t* pcs) {
+
+  uintptr_t* fp   = __builtin_frame_address(0);
+  uintptr_t  here = (uintptr_t)fp;
+  if (here < profile_stack_low || here >= profile_stack_high) {
+    if (!find_mapping(here, &profile_stack_low, &profile_stack_high)) {
+      return 0;
+    }
+  }
+
+  uint32_t depth = 0;
+  while (depth < PROFILE_DEPTH && ((uintptr_t)fp & (sizeof(uintptr_t) - 1)) == 0 &&
+	 (uintptr_t)fp >= profile_stack_low &&
+	 (uintptr_t)fp + 2 * sizeof(uintptr_t) <= profile_stack_high) {
+    uintptr_t  pc   = fp[1];
+    uintptr_t* next = (uintptr_t*)fp[0];
+    if (pc == 0) {
+      break;
+    }
+    if (depth > 0 || pc < profile_text_low || pc >= profile_text_high) {
+      pcs[depth++] = pc;
+    }
+    if (next <= fp) {
+      break;
+    }
+    fp = next;
+  }
+  return depth;
+
+} // profile_unwind ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Find the call site of a stack, entering it if it is new.
+ *
+ * \param pcs   The stack's return addresses.
+ * \param depth The number of them.
+ * \return      The site's index, or `UINT32_MAX` if the table is full.
+ */
+static uint32_t profile_site (const uintptr_t* pcs, uint32_t depth) {
+
+  uint64_t hash = depth;
+  for (uint32_t i = 0; i < depth; i++) {
+    hash = (hash ^ pcs[i]) * 0x9e3779b97f4a7c15ULL;
+  }
+  hash |= 1;
+
+  for (uint32_t probe = 0, i = (hash >> 32) & (PROFILE_SITES - 1); probe < PROFILE_SITES;
+       probe++, i = (i + 1) & (PROFILE_SITES - 1)) {
+    profile_site_s* site = &profile_sites[i];
+    if (site->hash == 0) {
+      site->hash  = hash;
+      site->depth = depth;
+      memcpy(site->pcs, pcs, depth * sizeof(uintptr_t));
+      return i;
+    }
+    if (site->hash == hash && site->depth == depth &&
+	memcmp(site->pcs, pcs, depth * sizeof(uintptr_t)) == 0) {
+      return i;
+    }
+  }
+  return UINT32_MAX;
+
+} // profile_site ()
+
+
+
+/** The entry at which the search for sampled block `addr` begins. */
+static inline size_t profile_home (uintptr_t addr) {
+  return (size_t)((addr >> 4) * 0x9e3779b97f4a7c15ULL) & (PROFILE_SAMPLES - 1);
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Sample a block that used up the bytes left until the next sample: record its
+ * stack's call site, and the block itself, so that its freeing can be counted
+ * there; and draw the bytes until the next one.
+ *
+ * \param size  The block's size.
+ * \param block The block.
+ */
+__attribute__((noinline, cold))
+static void profile_alloc (size_t size, void* block) {
+
+  if (profile_rate == 0) {
+    profile_countdown = INT64_MAX;
+    return;
+  }
+  profile_countdown = profile_interval();
+
+  uintptr_t pcs[PROFILE_DEPTH];
+  uint32_t  depth = profile_unwind(pcs);
+  uint32_t  index = profile_site(pcs, depth);
+  if (index == UINT32_MAX || 4 * (profile_live + 1) > 3 * PROFILE_SAMPLES) {
+    profile_dropped++;
+    return;
+  }
+
+  profile_site_s* site     = &profile_sites[index];
+  uint64_t        estimate = profile_estimate(size);
+  for (int count = PROFILE_ALLOCATED; count <= PROFILE_LIVE; count++) {
+    site->objects[count]++;
+    site->bytes[count]    += size;
+    site->estimate[count] += estimate;
+  }
+
+  size_t i = profile_home((uintptr_t)block);
+  while (profile_samples[i].addr != 0) {
+    i = (i + 1) & (PROFILE_SAMPLES - 1);
+  }
+  profile_samples[i].addr     = (uintptr_t)block;
+  profile_samples[i].site     = index;
+  profile_samples[i].estimate = estimate;
+  profile_live++;
+
+} // profile_alloc ()
+
+
+
+/**
+ * Forget a block as it is freed, if it was sampled, counting it at its call
+ * site as dead unless it was reclaimed.
+ *
+ * \param ptr       The block.
+ * \param size      Its size.
+ * \param reclaimed Whether the heap took its space back.
+ */
+static void profile_free (void* ptr, size_t size, bool reclaimed) {
+
+  size_t i = profile_home((uintptr_t)ptr);
+  while (profile_samples[i].addr != (uintptr_t)ptr) {
+    if (profile_samples[i].addr == 0) {
+      return;
+    }
+    i = (i + 1) & (PROFILE_SAMPLES - 1);
+  }
+
+  profile_site_s* site     = &profile_sites[profile_samples[i].site];
+  uint64_t        estimate = profile_samples[i].estimate;
+  site->objects[PROFILE_LIVE]--;
+  site->bytes[PROFILE_LIVE]    -= size;
+  site->estimate[PROFILE_LIVE] -= estimate;
+  if (!reclaimed) {
+    site->objects[PROFILE_DEAD]++;
+    site->bytes[PROFILE_DEAD]    += size;
+    site->estimate[PROFILE_DEAD] += estimate;
+  }
+
+  // Shift back each later entry of the run that may no longer be reachable.
+  for (size_t j = (i + 1) & (PROFILE_SAMPLES - 1);
+       profile_samples[j].addr != 0;
+       j = (j + 1) & (PROFILE_SAMPLES - 1)) {
+    size_t home = profile_home(profile_samples[j].addr);
+    if (((j - home) & (PROFILE_SAMPLES - 1)) >= ((j - i) & (PROFILE_SAMPLES - 1))) {
+      profile_samples[i] = profile_samples[j];
+      i = j;
+    }
+  }
+  profile_samples[i].addr = 0;
+  profile_live--;
+
+} // profile_free ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Write the heap profile to the file named by `PROFILE_ENV`, replacing what
+ * was there, in the format chosen by `PROFILE_FORMAT_ENV`.
+ */
+static void profile_write_file () {
+
+  if (profile_path == NULL) {
+    return;
+  }
+  int fd = open(profile_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd >= 0) {
+    pb_profile_dump(fd, profile_format);
+    close(fd);
+  }
+
+} // profile_write_file ()
+
+
+
+/**
+ * Write the heap profile on the signal named by `PROFILE_SIGNAL_ENV`, with no
+ * frames named, since nothing that names them is safe here.
+ *
+ * \param signo The signal.
+ */
+static void profile_signal (int signo) {
+
+  int saved_errno = errno;
+  profile_in_signal = true;
+  profile_write_file();
+  profile_in_signal = false;
+  errno = saved_errno;
+
+} // profile_signal ()
+
+
+
+/**
+ * Write the heap profile as the process exits.
+ */
+__attribute__((destructor))
+static void stop_profile () {
+
+  profile_write_file();
+
+} // stop_profile ()
+
+
+
+/**
+ * Leave the heap profile to the parent in a child process, which would
+ * otherwise write its own over the parent's at exit.
+ */
+static void abandon_profile () {
+
+  profile_path = NULL;
+
+} // abandon_profile ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * If `PROFILE_ENV` names a file, begin profiling: map the tables, find this
+ * library's code, and draw the bytes until the first sample.  Any failure
+ * leaves profiling off.  Nothing here allocates.
+ */
+static void start_profile () {
+
+  const char* path = getenv(PROFILE_ENV);
+  if (path == NULL || path[0] == '\0') {
+    return;
+  }
+
+  uintptr_t here = (uintptr_t)&profile_alloc;
+  if (!find_mapping(here, &profile_text_low, &profile_text_high)) {
+    return;
+  }
+  size_t sites_size   = PROFILE_SITES * sizeof(profile_site_s);
+  size_t samples_size = PROFILE_SAMPLES * sizeof(profile_sample_s);
+  void*  tables       = mmap(NULL, sites_size + samples_size, PROT_READ | PROT_WRITE,
+			     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (tables == MAP_FAILED) {
+    return;
+  }
+  profile_sites   = tables;
+  profile_samples = (profile_sample_s*)((char*)tables + sites_size);
+
+  static const char* formats[] = {
+    [PB_PROFILE_PPROF]     = "pprof",
+    [PB_PROFILE_ALLOCATED] = "allocated",
+    [PB_PROFILE_LIVE]      = "live",
+    [PB_PROFILE_DEAD]      = "dead"
+  };
+  const char* format = getenv(PROFILE_FORMAT_ENV);
+  for (int i = 0; format != NULL && i < (int)(sizeof(formats) / sizeof(formats[0])); i++) {
+    if (strcmp(format, formats[i]) == 0) {
+      profile_format = i;
+    }
+  }
+
+  const char* rate = getenv(PROFILE_RATE_ENV);
+  profile_rate = rate != NULL && strtoull(rate, NULL, 10) > 0 ? strtoull(rate, NULL, 10) : PROFILE_RATE;
+  profile_random    = tick_count() ^ ((uint64_t)getpid() << 32) ^ here;
+  profile_random   |= 1;
+  profile_countdown = profile_interval();
+  profile_path      = path;
+
+  const char* signo = getenv(PROFILE_SIGNAL_ENV);
+  if (signo != NULL && atoi(signo) > 0) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = profile_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(atoi(signo), &action, NULL);
+  }
+  pthread_atfork(NULL, NULL, abandon_profile);
+
+} // start_profile ()
+// ==============================================================================
+#endif /* PB_PROFILE */
+
+
+
+#if defined (PB_SITES)
+// ==============================================================================
+/**
+ * Find the entry for a call site, claiming one if it is new, within a few
+ * probes of where its search begins.
+ *
+ * \param pc The caller's return address.
+ * \return   The site's entry; or, if none is free nearby, the one that counts
+ *           the sites that found the table full.
+ */
+static inline pb_site_s* find_site (uintptr_t pc) {
+
+  size_t i = (size_t)(((pc >> 2) * 0x9e3779b97f4a7c15ULL) >> 32) & (SITES_TABLE - 1);
+  for (int probe = 0; probe < 16; probe++, i = (i + 1) & (SITES_TABLE - 1)) {
+    uintptr_t key = sites[i].pc;
+    if (key == pc) {
+      return &sites[i];
+    }
+    if (key == 0) {
+      __atomic_store_n(&sites[i].pc, pc, __ATOMIC_RELAXED);
+      return &sites[i];
+    }
+  }
+  return &sites_full;
+
+} // find_site ()
+
+
+
+/**
+ * Count a call at its call site, unless it is nested within another entry
+ * point's call or the heap is not yet initialized.
+ *
+ * \param pc   The caller's return address.
+ * \param size The bytes requested.
+ */
+static inline void count_site (uintptr_t pc, size_t size) {
+
+  if (__builtin_expect(sites == NULL || entry_depth != 0, 0)) {
+    return;
+  }
+  pb_site_s* site = find_site(pc);
+  STAT_ADD(site, calls, 1);
+  STAT_ADD(site, bytes, size);
+
+} // count_site ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Print the busiest call sites on the signal named by `SITES_SIGNAL_ENV`, or
+ * the default number of them if `SITES_ENV` does not give one, by address
+ * alone, since nothing that names them is safe here.
+ *
+ * \param signo The signal.
+ */
+static void sites_signal (int signo) {
+
+  int saved_errno = errno;
+  sites_in_signal = true;
+  pb_sites_dump(STDERR_FILENO, sites_top != 0 ? sites_top : 20);
+  sites_in_signal = false;
+  errno = saved_errno;
+
+} // sites_signal ()
+
+
+
+/**
+ * Print the busiest call sites as the process exits, if `SITES_ENV` asked.
+ */
+__attribute__((destructor))
+static void stop_sites () {
+
+  if (sites_top != 0) {
+    pb_sites_dump(STDERR_FILENO, sites_top);
+  }
+
+} // stop_sites ()
+
+
+
+/**
+ * Map the table of call sites, which starts the counting; note how many of the
+ * busiest to print at exit; and print them on a signal if one is named.
+ * Nothing here allocates.
+ */
+static void start_sites () {
+
+  void* table = mmap(NULL, SITES_TABLE * sizeof(pb_site_s), PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (table == MAP_FAILED) {
+    return;
+  }
+  sites = table;
+
+  const char* top = getenv(SITES_ENV);
+  if (top != NULL) {
+    sites_top = strtoull(top, NULL, 10);
+    sites_top = sites_top < SITES_TOP_MAX ? sites_top : SITES_TOP_MAX;
+  }
+
+  const char* signo = getenv(SITES_SIGNAL_ENV);
+  if (signo != NULL && atoi(signo) > 0) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = sites_signal;
+    action.sa_flags   = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(atoi(signo), &action, NULL);
+  }
+
+} // start_sites ()
+// ==============================================================================
+#endif /* PB_SITES */
+
+
+
+// ==============================================================================
+/**
+ * The initialization method.  If this is the first use of the heap, initialize it.
+ */
+
+void init () {
+
+  // Only do anything if there is no heap region (i.e., first time called).
+  if (start_addr == 0) {
+
+    DEBUG("Trying to initialize");
+    
+    // Allocate virtual address space in which the heap will reside. Make it
+    // un-shared and not backed by any file (_anonymous_ space).  A failure to
+    // map this space is fatal.
+    void* heap = mmap(NULL,
+		      HEAP_SIZE,
+		      PROT_READ | PROT_WRITE,
+		      MAP_PRIVATE | MAP_ANONYMOUS,
+		      -1,
+		      0);
+    if (heap == MAP_FAILED) {
+      ERROR("Could not mmap() heap region");
+    }
+
+    // Hold onto the boundaries of the heap as a whole.
+    start_addr = (intptr_t)heap;
+    end_addr   = start_addr + HEAP_SIZE;
+    pb_heap.start_addr = (char*)start_addr;
+    pb_heap.limit_addr = (char*)end_addr;
+    pb_arena_reset(&pb_heap);
+    PB_PROBE2(init, pb_heap.start_addr, pb_heap.limit_addr);
+
+#if defined (PB_STATS)
+    publish_stats_page();
+#endif
+#if defined (PB_TRACE)
+    start_trace();
+#endif
+#if defined (PB_LATENCY)
+    start_latency();
+#endif
+#if defined (PB_PROFILE)
+    start_profile();
+#endif
+#if defined (PB_SITES)
+    start_sites();
+#endif
+
+    // DEBUG: Emit a message to indicate that this allocator is being called.
+    DEBUG("bp-alloc initialized");
+
+  }
+
+} // init ()
+// ==============================================================================
+
+
+// ==============================================================================
+/**
+ * Initialize the heap as the library is loaded, which takes `init()` off the
+ * `malloc()` path entirely.  Anything allocated before this runs (e.g., by an
+ * earlier library's constructor) finds the cursors still zero, and so falls
+ * through to `malloc_slow()`, which initializes the heap itself.
+ */
+__attribute__((constructor))
+static void init_early () {
+
+  init();
+
+} // init_early ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The footprint of a block of `size` bytes once its header is included and it
+ * is rounded up to keep the next header ready.
+ *
+ * \param size The number of bytes in the block.
+ * \return     The number of bytes of heap the block consumes.
+ */
+static inline size_t block_footprint (size_t size) {
+
+  return (size + sizeof(header_s) + DBL_WORD_SIZE - 1) & -(size_t)DBL_WORD_SIZE;
+
+} // block_footprint ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The cursor that `malloc()` bumps.
+ *
+ * \return The cursor's current position.
+ */
+static inline char* malloc_cursor () {
+
+#if !defined (PB_BUMP_DOWN)
+  return pb_heap.free_addr;
+#else
+  return pb_heap.end_addr;
+#endif
+
+} // malloc_cursor ()
+
+
+
+#if defined (PB_STATS)
+/**
+ * Begin an update of a statistics page, marking it as under way for readers.
+ *
+ * \param page The page to update.
+ * \return     The page's sequence number before the update.
+ */
+static inline uint64_t begin_update (pb_shm_page_s* page) {
+
+  uint64_t seq = page->seq;
+  __atomic_store_n(&page->seq, seq + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  return seq;
+
+} // begin_update ()
+
+
+
+/**
+ * End an update of a statistics page, publishing the heap's cursors with it.
+ *
+ * \param page The page being updated.
+ * \param seq  What `begin_update()` returned.
+ */
+static inline void end_update (pb_shm_page_s* page, uint64_t seq) {
+
+  __atomic_store_n(&page->free_addr, pb_heap.free_addr, __ATOMIC_RELAXED);
+  __atomic_store_n(&page->end_addr,  pb_heap.end_addr,  __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  __atomic_store_n(&page->seq, seq + 2, __ATOMIC_RELAXED);
+
+} // end_update ()
+#endif /* PB_STATS */
+
+
+
+/**
+ * Count a block just allocated.  Does nothing unless built with `PB_STATS`.
+ *
+ * \param size   The number of bytes requested.
+ * \param before Where `malloc_cursor()` was before the allocation.
+ */
+static inline void count_alloc (size_t size, char* before) {
+
+#if defined (PB_STATS)
+  char*  after    = malloc_cursor();
+  size_t consumed = after > before ? after - before : before - after;
+  size_t in_use   = ((pb_heap.free_addr - pb_heap.start_addr)
+		     + (pb_heap.limit_addr - pb_heap.end_addr));
+
+  pb_shm_page_s* page = stats_page;
+  uint64_t       seq  = begin_update(page);
+  STAT_ADD(page, stats.malloc_calls, 1);
+  STAT_ADD(page, stats.requested,    size);
+  STAT_ADD(page, stats.allocated,    consumed);
+  STAT_ADD(page, stats.header_bytes, sizeof(header_s));
+  STAT_ADD(page, histogram[pb_shm_class(size)], 1);
+  if (in_use > page->stats.peak) {
+    __atomic_store_n(&page->stats.peak, in_use, __ATOMIC_RELAXED);
+  }
+  end_update(page, seq);
+#endif /* PB_STATS */
+
+} // count_alloc ()
+
+
+
+/**
+ * Count a run of blocks just allocated with a single bump, each as a call to
+ * `malloc()`.  Does nothing unless built with `PB_STATS`.
+ *
+ * \param sizes  The number of bytes requested for each block, or `NULL` if
+ *               every block asked for `size`.
+ * \param size   The number of bytes requested for every block, if `sizes` is
+ *               `NULL`.
+ * \param count  The number of blocks.
+ * \param before Where `malloc_cursor()` was before the allocation.
+ */
+static inline void count_batch (const size_t* sizes, size_t size, size_t count, char* before) {
+
+#if defined (PB_STATS)
+  char*  after     = malloc_cursor();
+  size_t consumed  = after > before ? after - before : before - after;
+  size_t in_use    = ((pb_heap.free_addr - pb_heap.start_addr)
+		      + (pb_heap.limit_addr - pb_heap.end_addr));
+  size_t requested = 0;
+
+  pb_shm_page_s* page = stats_page;
+  uint64_t       seq  = begin_update(page);
+  for (size_t i = 0; i < count; i++) {
+    size_t block_size  = sizes != NULL ? sizes[i] : size;
+    requested         += block_size;
+    STAT_ADD(page, histogram[pb_shm_class(block_size)], 1);
+  }
+  STAT_ADD(page, stats.malloc_calls, count);
+  STAT_ADD(page, stats.requested,    requested);
+  STAT_ADD(page, stats.allocated,    consumed);
+  STAT_ADD(page, stats.header_bytes, count * sizeof(header_s));
+  if (in_use > page->stats.peak) {
+    __atomic_store_n(&page->stats.peak, in_use, __ATOMIC_RELAXED);
+  }
+  end_update(page, seq);
+#endif /* PB_STATS */
+
+} // count_batch ()
+
+
+
+/**
+ * Count a block just freed, which was reclaimed if the cursor has moved, and is
+ * dead otherwise.  Does nothing unless built with `PB_STATS`.
+ *
+ * \param size   The size with which the block was allocated.
+ * \param before Where `malloc_cursor()` was before the block was freed.
+ */
+static inline void count_free (size_t size, char* before) {
+
+#if defined (PB_STATS)
+  char*          after = malloc_cursor();
+  pb_shm_page_s* page  = stats_page;
+  uint64_t       seq   = begin_update(page);
+  if (after == before) {
+    STAT_ADD(page, stats.dead_bytes, block_footprint(size));
+  } else {
+    // A block from an inline path compiled without PB_STATS was never counted;
+    // take nothing for one that the counts could not hold, rather than wrap
+    // them below zero.
+    size_t released  = after > before ? after - before : before - after;
+    size_t requested = page->stats.requested;
+    size_t allocated = page->stats.allocated;
+    size_t headers   = page->stats.header_bytes;
+    if (requested >= size && allocated >= released && headers >= sizeof(header_s) &&
+	allocated - released >= (requested - size) + (headers - sizeof(header_s))) {
+      STAT_ADD(page, stats.requested,    -size);
+      STAT_ADD(page, stats.allocated,    -released);
+      STAT_ADD(page, stats.header_bytes, -sizeof(header_s));
+    }
+  }
+  end_update(page, seq);
+#endif /* PB_STATS */
+
+} // count_free ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The rare cases of `malloc()`: a zero-byte or absurdly large request, a heap
+ * that is not yet initialized, or a heap that is exhausted.
+ *
+ * \param size The number of bytes to allocate.
+ * \return     A pointer to the allocated block, if successful; `NULL` if
+ *             unsuccessful.
+ */
+__attribute__((noinline, cold))
+static void* malloc_slow (size_t size) {
+
+  /** The malloc probe fires only on the fast path, so that this one can be
+   *  a tail call; a retry after initializing the heap fires it from there. */
+  PB_PROBE2(malloc_slow, size, malloc_cursor());
+
+  /** If trying to allocate a block of zero length, return a null pointer. */
+  if (size == 0 || size > HEAP_SIZE) {
+    return NULL;
+  }
+
+  /** Initialize the heap and try again; otherwise the heap is full. */
+  if (start_addr == 0) {
+    init();
+    NEST();
+    void* block_ptr = malloc(size);
+    UNNEST();
+    return block_ptr;
+  }
+
+  return NULL;
+
+} // malloc_slow ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate and return `size` bytes of heap space.  Expand into the heap region
+ * via _pointer bumping_.
+ *
+ * \param size The number of bytes to allocate.
+
+ * \return A pointer to the allocated block, if successful; `NULL` if
+ *         unsuccessful.
+ */
+void* malloc (size_t size) {
+
+  /** Carve the block, header and all, out of the heap.  The arithmetic lives
+   *  in pb_arena_alloc() (see pb-alloc.h), since it depends on the direction
+   *  of bumping: upward from free_addr by default, which is always kept
+   *  sizeof(header_s) short of a double-word boundary so that no padding
+   *  ever needs computing; or downward from end_addr with PB_BUMP_DOWN. */
+  COUNT_SITE(size);
+  uint64_t start     = LATENCY_SAMPLE();
+  char*    before    = malloc_cursor();
+  void*    block_ptr = pb_arena_alloc(&pb_heap, size);
+
+  /** A zero-byte request, a full heap, or one not yet initialized all come
+   *  back as a null pointer; let the slow path sort them out. */
+  if (__builtin_expect(block_ptr == NULL, 0)) {
+    start     = LATENCY_START(start);
+    block_ptr = malloc_slow(size);
+    LATENCY_SLOW(PB_LATENCY_MALLOC, start);
+    TRACE(PB_TRACE_MALLOC, size, block_ptr, NULL);
+    return block_ptr;
+  }
+
+  count_alloc(size, before);
+  PROFILE_ALLOC(size, block_ptr);
+  LATENCY_FAST(PB_LATENCY_MALLOC, start);
+  TRACE(PB_TRACE_MALLOC, size, block_ptr, NULL);
+  PB_PROBE3(malloc, size, block_ptr, malloc_cursor());
+  return block_ptr;
+
+} // malloc()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Deallocate a given block on the heap.  Only the block at the top of the heap
+ * is actually reclaimed.
+ *
+ * \param ptr A pointer to the block to be deallocated.
+ */
+void free (void* ptr) {
+
+  DEBUG("free(): ", (intptr_t)ptr);
+
+  /** Freed blocks are not re-used, but the most recently allocated one can
+   *  simply be un-bumped. */
+  uint64_t start = LATENCY_SAMPLE();
+  COUNT_CALL(free_calls);
+  if (ptr != NULL) {
+    char*  before = malloc_cursor();
+    size_t size   = ((header_s*)ptr)[-1].size;
+    pb_arena_free_sized(&pb_heap, ptr, size);
+    count_free(size, before);
+    PROFILE_FREE(ptr, size, malloc_cursor() != before);
+    TRACE(PB_TRACE_FREE, size, ptr, NULL);
+    PB_PROBE3(free, ptr, size, malloc_cursor());
+  }
+  LATENCY_FAST(PB_LATENCY_FREE, start);
+
+} // free()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a block of `nmemb * size` bytes on the heap, zeroing its contents.
+ *
+ * \param nmemb The number of elements in the new block.
+ * \param size  The size, in bytes, of each of the `nmemb` elements.
+ * \return      A pointer to the newly allocated and zeroed block, if successful;
+ *              `NULL` if unsuccessful.
+ */
+void* calloc (size_t nmemb, size_t size) {
+
+  uint64_t start = LATENCY_SAMPLE();
+  COUNT_CALL(calloc_calls);
+
+  // Allocate a block of the requested size.
+  size_t block_size = nmemb * size;
+  COUNT_SITE(block_size);
+  NEST();
+  void*  block_ptr  = malloc(block_size);
+  UNNEST();
+  TRACE(PB_TRACE_CALLOC, block_size, block_ptr, NULL);
+  PB_PROBE3(calloc, block_size, block_ptr, malloc_cursor());
+
+  // If the allocation succeeded, clear the entire block.
+  if (block_ptr != NULL) {
+    memset(block_ptr, 0, block_size);
+  }
+
+  LATENCY_FAST(PB_LATENCY_CALLOC, start);
+  return block_ptr;
+  
+} // calloc ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Update the given block at `ptr` to take on the given `size`.  Here, if `size`
+ * fits within the given block, then the block is returned unchanged.  If the
+ * `size` is an increase for the block, then a new and larger block is
+ * allocated, and the data from the old block is copied, the old block freed,
+ * and the new block returned.
+ *
+ * \param ptr  The block to be assigned a new size.
+ * \param size The new size that the block should assume.
+ * \return     A pointer to the resultant block, which may be `ptr` itself, or
+ *             may be a newly allocated block.
+ */
+void* realloc (void* ptr, size_t size) {
+
+  uint64_t start = LATENCY_SAMPLE();
+  COUNT_CALL(realloc_calls);
+  COUNT_SITE(size);
+
+  /** If passed in a null pointer, then presumably there's no pre-existent
+   *  block. As such, call malloc to allocate a new one of the desired size. */
+  if (ptr == NULL) {
+    NEST();
+    void* new_ptr = malloc(size);
+    UNNEST();
+    TRACE(PB_TRACE_REALLOC, size, new_ptr, NULL);
+    PB_PROBE4(realloc, NULL, size, new_ptr, malloc_cursor());
+    LATENCY_FAST(PB_LATENCY_REALLOC, start);
+    return new_ptr;
+  }
+
+  /** If passed a new size of 0, this is basically the same as freeing the
+   *  block. So call free and return a null pointer. */
+  if (size == 0) {
+    NEST();
+    free(ptr);
+    UNNEST();
+    TRACE(PB_TRACE_REALLOC, 0, NULL, ptr);
+    PB_PROBE4(realloc, ptr, 0, NULL, malloc_cursor());
+    LATENCY_FAST(PB_LATENCY_REALLOC, start);
+    return NULL;
+  }
+
+  /** old_header gets the address of the header of the old (i.e. un-reallocated)
+   *  block of memory. This is done by walking backwards from the block pointer
+   *  a number of bytes equal to the known header size. */
+  header_s* old_header = (header_s*)((intptr_t)ptr - sizeof(header_s));
+
+  /** Read in the size of the old block of memory from the old header. */
+  size_t    old_size   = old_header->size;
+
+  /** If the new size the program asks for is less than or equal to the old
+   *  size, simply return the old pointer - there's enough space in the current
+   *  block already. */
+  if (size <= old_size) {
+    TRACE(PB_TRACE_REALLOC, size, ptr, ptr);
+    PB_PROBE4(realloc, ptr, size, ptr, malloc_cursor());
+    LATENCY_FAST(PB_LATENCY_REALLOC, start);
+    return ptr;
+  }
+
+  /** Otherwise (i.e. if the program is asking for a bigger size than the 
+   *  old one), call malloc to allocate a new block of that size somewhere
+   *  else that might be available.  Moving the block is the slow path, and so
+   *  is always timed. */
+  start = LATENCY_START(start);
+  NEST();
+  void* new_ptr = malloc(size);
+
+  /** If the allocation succeeded (i.e. the pointer returned by malloc is not
+   *  null), then copy all the contents of the old block into the new block,
+   *  and free the old block. */
+  if (new_ptr != NULL) {
+    memcpy(new_ptr, ptr, old_size);
+    free(ptr);
+  }
+  UNNEST();
+  TRACE(PB_TRACE_REALLOC, size, new_ptr, ptr);
+  PB_PROBE4(realloc, ptr, size, new_ptr, malloc_cursor());
+  LATENCY_SLOW(PB_LATENCY_REALLOC, start);
+
+  /** Return a pointer to the newly allocated block of memory. */
+  return new_ptr;
+  
+} // realloc()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Count the bytes of resident pages in a range of the heap, a chunk of pages
+ * at a time so as to need no allocation.
+ *
+ * \param low  The start of the range.
+ * \param high The end of the range.
+ * \return     The number of bytes in resident pages that overlap the range.
+ */
+static size_t resident_bytes (char* low, char* high) {
+
+  size_t    page_size = PAGE_SIZE;
+  uintptr_t page      = (uintptr_t)low & -page_size;
+  uintptr_t end       = ((uintptr_t)high + page_size - 1) & -page_size;
+  size_t    resident  = 0;
+  while (page < end) {
+    size_t pages = (end - page) / page_size;
+    pages = pages < RESIDENCY_CHUNK_PAGES ? pages : RESIDENCY_CHUNK_PAGES;
+    if (mincore((void*)page, pages * page_size, residency) == 0) {
+      for (size_t i = 0; i < pages; i++) {
+	resident += (residency[i] & 1) * page_size;
+      }
+    }
+    page += pages * page_size;
+  }
+  return resident;
+
+} // resident_bytes ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Report the heap's usage in the form glibc uses.  The whole consumed span of
+ * the heap counts as the arena; blocks freed but never reclaimed count as free
+ * (in a build with `PB_STATS`; otherwise none are known); and the resident
+ * pages between the cursors, which `malloc_trim()` can release, are the keep
+ * cost.
+ *
+ * \return The heap's usage.
+ */
+struct mallinfo2 mallinfo2 (void) {
+
+  pb_stats_s stats;
+  pb_stats(&stats);
+
+  struct mallinfo2 info;
+  memset(&info, 0, sizeof(info));
+  info.arena    = stats.in_use;
+  info.ordblks  = stats.dead_bytes > 0 ? 1 : 0;
+  info.uordblks = stats.in_use - stats.dead_bytes;
+  info.fordblks = stats.dead_bytes;
+  if (start_addr != 0) {
+    info.keepcost = resident_bytes(pb_heap.free_addr, pb_heap.end_addr);
+  }
+  return info;
+
+} // mallinfo2 ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Report the heap's usage as `mallinfo2()` does, truncated to the `int` fields
+ * of the older interface.
+ *
+ * \return The heap's usage.
+ */
+struct mallinfo mallinfo (void) {
+
+  struct mallinfo2 info2 = mallinfo2();
+  struct mallinfo  info;
+  info.arena    = (int)info2.arena;
+  info.ordblks  = (int)info2.ordblks;
+  info.smblks   = (int)info2.smblks;
+  info.hblks    = (int)info2.hblks;
+  info.hblkhd   = (int)info2.hblkhd;
+  info.usmblks  = (int)info2.usmblks;
+  info.fsmblks  = (int)info2.fsmblks;
+  info.uordblks = (int)info2.uordblks;
+  info.fordblks = (int)info2.fordblks;
+  info.keepcost = (int)info2.keepcost;
+  return info;
+
+} // mallinfo ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Print the heap's usage to `stderr`, leading with the lines that glibc's
+ * version prints, and without allocating.
+ */
+void malloc_stats (void) {
+
+  pb_stats_s stats;
+  bool       counted  = pb_stats(&stats);
+  size_t     resident = 0;
+  size_t     idle     = 0;
+  if (start_addr != 0) {
+    resident = (resident_bytes(pb_heap.start_addr, pb_heap.free_addr) +
+		resident_bytes(pb_heap.end_addr, pb_heap.limit_addr));
+    idle     = resident_bytes(pb_heap.free_addr, pb_heap.end_addr);
+  }
+
+  struct {
+    const char* label;
+    size_t      value;
+    bool        shown;
+  } lines[] = {
+    { "system bytes     = ", stats.in_use,                    true    },
+    { "in use bytes     = ", stats.in_use - stats.dead_bytes, true    },
+    { "reserved bytes   = ", stats.heap_size,                 true    },
+    { "raw bytes        = ", stats.raw_bytes,                 true    },
+    { "dead bytes       = ", stats.dead_bytes,                counted },
+    { "peak bytes       = ", stats.peak,                      counted },
+    { "resident bytes   = ", resident,                        true    },
+    { "trimmable bytes  = ", idle,                            true    },
+  };
+
+  safe_puts(STDERR_FILENO, "Arena 0:\n");
+  for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+    if (lines[i].shown) {
+      safe_puts(STDERR_FILENO, lines[i].label);
+      safe_putu(STDERR_FILENO, lines[i].value, 10);
+      safe_puts(STDERR_FILENO, "\n");
+    }
+  }
+  pb_latency_dump(STDERR_FILENO);
+
+} // malloc_stats ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Hand the resident pages between the cursors back to the kernel, keeping
+ * `pad` bytes beyond the headered blocks' cursor.  They read as zero if used
+ * again.
+ *
+ * \param pad The number of bytes to leave resident past the cursor.
+ * \return    1 if any memory was released; 0 if not.
+ */
+int malloc_trim (size_t pad) {
+
+  if (start_addr == 0) {
+    return 0;
+  }
+
+  // Only whole pages strictly between the cursors can go.
+  size_t    page_size = PAGE_SIZE;
+  uintptr_t free_addr = (uintptr_t)pb_heap.free_addr;
+  uintptr_t end_addr  = (uintptr_t)pb_heap.end_addr;
+  if (pad > end_addr - free_addr) {
+    return 0;
+  }
+#if !defined (PB_BUMP_DOWN)
+  free_addr += pad;
+#else
+  end_addr  -= pad;
+#endif
+  uintptr_t low  = (free_addr + page_size - 1) & -page_size;
+  uintptr_t high = end_addr & -page_size;
+  if (low >= high || resident_bytes((char*)low, (char*)high) == 0) {
+    return 0;
+  }
+
+  return madvise((void*)low, high - low, MADV_DONTNEED) == 0;
+
+} // malloc_trim ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a block when the inline fast path in `pb-alloc.h` could not.  This
+ * is simply `malloc()`, which initializes the heap if needed.
+ *
+ * \param size The number of bytes to allocate.
+ * \return     A pointer to the allocated block, if successful; `NULL` if
+ *             unsuccessful.
+ */
+void* pb_malloc_slow (size_t size) {
+
+  return malloc(size);
+
+} // pb_malloc_slow ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a headerless block when the inline fast path in `pb-alloc.h` could
+ * not: the heap was not yet initialized, or the request does not fit.
+ *
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_alloc_raw_slow (size_t size, size_t align) {
+
+  init();
+
+  // Reject alignments that the mask arithmetic cannot express.
+  if (align == 0 || (align & (align - 1)) != 0) {
+    return NULL;
+  }
+
+  void* block_ptr = pb_arena_alloc_raw(&pb_heap, size, align);
+  PB_PROBE3(alloc_raw_slow, size, align, block_ptr);
+  return block_ptr;
+
+} // pb_alloc_raw_slow ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Point the cursors of `arena` at the two ends of its region.
+ *
+ * \param arena The region to empty.
+ */
+static void reset_cursors (pb_arena_s* arena) {
+
+#if !defined (PB_BUMP_DOWN)
+  // Leave free_addr just short of a double-word boundary, ready for the header
+  // of the first block; pb_arena_alloc() keeps it that way.  end_addr starts on
+  // such a boundary, which raw blocks of pb_raw_footprint() sizes keep it on.
+  arena->free_addr = arena->start_addr + DBL_WORD_SIZE - sizeof(header_s);
+  arena->end_addr  = (char*)((uintptr_t)arena->limit_addr
+			     & -(uintptr_t)DBL_WORD_SIZE);
+#else
+  // Likewise leave end_addr just above a double-word boundary by the size of a
+  // header, so that every block consumes exactly its rounded-up footprint and
+  // freeing it can restore the cursor exactly.
+  arena->free_addr = arena->start_addr;
+  arena->end_addr  = (char*)((((uintptr_t)arena->limit_addr - sizeof(header_s))
+			      & -(uintptr_t)DBL_WORD_SIZE)
+			     + sizeof(header_s));
+#endif
+
+} // reset_cursors ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Make `arena` a region over the `size` bytes at `buffer`.
+ *
+ * \param arena  The arena to initialize.
+ * \param buffer The memory to allocate from.
+ * \param size   The number of bytes at `buffer`.
+ * \return       `true` if successful; `false` if the buffer is too small.
+ */
+bool pb_arena_init_buffer (pb_arena_s* arena, void* buffer, size_t size) {
+
+  // Start on a double-word boundary, so that reset can make the cursor
+  // header-ready, and insist on room for at least one block.
+  uintptr_t start_addr = (((uintptr_t)buffer + DBL_WORD_SIZE - 1)
+			  & -(uintptr_t)DBL_WORD_SIZE);
+  uintptr_t limit_addr = (uintptr_t)buffer + size;
+  if (size < 2 * DBL_WORD_SIZE || limit_addr < start_addr + DBL_WORD_SIZE) {
+    return false;
+  }
+
+  memset(arena, 0, sizeof(*arena));
+  arena->start_addr = (char*)start_addr;
+  arena->limit_addr = (char*)limit_addr;
+  reset_cursors(arena);
+  PB_PROBE3(arena_init, arena, arena->start_addr, arena->limit_addr);
+  return true;
+
+} // pb_arena_init_buffer ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Make `arena` a region of `capacity` bytes carved from the heap.
+ *
+ * \param arena    The arena to initialize.
+ * \param capacity The number of bytes in the region.
+ * \return         `true` if successful; `false` if unsuccessful.
+ */
+bool pb_arena_init (pb_arena_s* arena, size_t capacity) {
+
+  void* region = pb_alloc_raw(capacity, DBL_WORD_SIZE);
+  if (region == NULL) {
+    return false;
+  }
+  if (!pb_arena_init_buffer(arena, region, capacity)) {
+    pb_free_raw(region, capacity);
+    return false;
+  }
+  return true;
+
+} // pb_arena_init ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Make `child` an empty arena whose chunks are carved from `parent`.
+ *
+ * \param child      The arena to initialize.
+ * \param parent     The arena to carve chunks from.
+ * \param chunk_size The size of the first chunk.
+ */
+void pb_arena_init_child (pb_arena_s* child, pb_arena_s* parent, size_t chunk_size) {
+
+  // With no region, every fast path fails, and the first allocation carves the
+  // first chunk.
+  memset(child, 0, sizeof(*child));
+  child->parent     = parent;
+  // Chunks are whole double words, so that carving them keeps the parent's raw
+  // cursor aligned, and handing them back in turn restores it exactly.
+  chunk_size        = chunk_size > MIN_CHUNK_SIZE ? chunk_size : MIN_CHUNK_SIZE;
+  chunk_size        = chunk_size < HEAP_SIZE      ? chunk_size : HEAP_SIZE;
+  child->chunk_size = (chunk_size + DBL_WORD_SIZE - 1) & -(size_t)DBL_WORD_SIZE;
+
+  child->next_sibling = parent->first_child;
+  if (parent->first_child != NULL) {
+    parent->first_child->prev_sibling = child;
+  }
+  parent->first_child = child;
+
+} // pb_arena_init_child ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Carve a chunk with room for at least `need` bytes from the parent of `arena`,
+ * and make it the arena's region.
+ *
+ * \param arena The child arena to refill.
+ * \param need  The number of bytes the chunk must be able to supply.
+ * \return      `true` if successful; `false` if the parent could not supply
+ *              the chunk, or `arena` is not a child.
+ */
+static bool refill_child (pb_arena_s* arena, size_t need) {
+
+  pb_arena_s* parent = arena->parent;
+  if (parent == NULL || need > HEAP_SIZE) {
+    return false;
+  }
+
+  // Take the next chunk in the geometric series if the parent has room for it,
+  // or else just enough for the request.  A chunk of whole double words ends on
+  // a double-word boundary, so that after the bookkeeping and the header offset
+  // that reset_cursors() leaves, the region still holds `need` bytes.
+  size_t minimum = (sizeof(chunk_s) + DBL_WORD_SIZE
+		    + ((need + DBL_WORD_SIZE - 1) & -(size_t)DBL_WORD_SIZE));
+  size_t size    = arena->chunk_size > minimum ? arena->chunk_size : minimum;
+  chunk_s* chunk = pb_arena_alloc_raw(parent, size, DBL_WORD_SIZE);
+  if (chunk == NULL) {
+    chunk = pb_arena_alloc_raw_slow(parent, size, DBL_WORD_SIZE);
+  }
+  if (chunk == NULL && size > minimum) {
+    // The inline path first, again: the slow path only refills, and a parent
+    // that is not itself a child cannot.
+    size  = minimum;
+    chunk = pb_arena_alloc_raw(parent, size, DBL_WORD_SIZE);
+    if (chunk == NULL) {
+      chunk = pb_arena_alloc_raw_slow(parent, size, DBL_WORD_SIZE);
+    }
+  }
+  PB_PROBE4(refill, arena, need, chunk, size);
+  if (chunk == NULL) {
+    return false;
+  }
+
+  chunk->prev   = arena->chunks;
+  chunk->size   = size;
+  arena->chunks = chunk;
+  if (size <= HEAP_SIZE / 2) {
+    arena->chunk_size = size * 2;
+  }
+
+  // What is left of the previous chunk is abandoned until the next reset.
+  arena->start_addr = (char*)(chunk + 1);
+  arena->limit_addr = (char*)chunk + size;
+  reset_cursors(arena);
+  return true;
+
+} // refill_child ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Empty every arena below `arena`, whose memory has just been freed from under
+ * them.  Each keeps its place in the tree, and refills when next used.
+ *
+ * \param arena The arena whose descendants to empty.
+ */
+static void invalidate_children (pb_arena_s* arena) {
+
+  for (pb_arena_s* child = arena->first_child;
+       child != NULL;
+       child = child->next_sibling) {
+    invalidate_children(child);
+    child->free_addr  = NULL;
+    child->end_addr   = NULL;
+    child->start_addr = NULL;
+    child->limit_addr = NULL;
+    child->chunks     = NULL;
+  }
+
+} // invalidate_children ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Hand the chunks of a child arena back to its parent, newest first, so that
+ * those at the top of the parent are reclaimed, and leave it with no region.
+ *
+ * \param arena The child arena to empty.
+ */
+static void release_chunks (pb_arena_s* arena) {
+
+  while (arena->chunks != NULL) {
+    chunk_s* prev = arena->chunks->prev;
+    pb_arena_free_raw(arena->parent, arena->chunks, arena->chunks->size);
+    arena->chunks = prev;
+  }
+
+  arena->free_addr  = NULL;
+  arena->end_addr   = NULL;
+  arena->start_addr = NULL;
+  arena->limit_addr = NULL;
+
+} // release_chunks ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Release everything allocated from `arena`.
+ *
+ * \param arena The region to reset.
+ */
+void pb_arena_reset (pb_arena_s* arena) {
+
+  invalidate_children(arena);
+  if (arena->parent != NULL) {
+    release_chunks(arena);
+  } else {
+    reset_cursors(arena);
+  }
+
+} // pb_arena_reset ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Release an arena made by `pb_arena_init()` or `pb_arena_init_child()`.
+ *
+ * \param arena The arena to destroy.
+ */
+void pb_arena_destroy (pb_arena_s* arena) {
+
+  // Children go first, so that their chunks are back before this arena's go.
+  while (arena->first_child != NULL) {
+    pb_arena_destroy(arena->first_child);
+  }
+
+  pb_arena_s* parent = arena->parent;
+  if (parent != NULL) {
+    release_chunks(arena);
+    if (arena->prev_sibling != NULL) {
+      arena->prev_sibling->next_sibling = arena->next_sibling;
+    } else {
+      parent->first_child = arena->next_sibling;
+    }
+    if (arena->next_sibling != NULL) {
+      arena->next_sibling->prev_sibling = arena->prev_sibling;
+    }
+  } else {
+    // The region began at or a little after the block carved for it, which
+    // ran all the way to its limit.
+    size_t capacity = arena->limit_addr - arena->start_addr;
+    pb_free_raw(arena->start_addr, capacity);
+  }
+  memset(arena, 0, sizeof(*arena));
+
+} // pb_arena_destroy ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Reserve `total` bytes of heap for a run of header-carrying blocks, in one
+ * bump in whichever direction `malloc()` bumps.  The heap must be initialized.
+ *
+ * \param total The number of bytes to reserve; a multiple of `DBL_WORD_SIZE`.
+ * \return      The start of the span, which is `sizeof(header_s)` short of a
+ *              double-word boundary, if successful; `NULL` if unsuccessful.
+ */
+static char* reserve_span (size_t total) {
+
+  uintptr_t free_addr = (uintptr_t)pb_heap.free_addr;
+  uintptr_t end_addr  = (uintptr_t)pb_heap.end_addr;
+  if (total > end_addr - free_addr) {
+    return NULL;
+  }
+
+#if !defined (PB_BUMP_DOWN)
+  // free_addr is already header-ready, and total keeps it so.
+  pb_heap.free_addr = (char*)(free_addr + total);
+  return (char*)free_addr;
+#else
+  // Drop the span low enough that its start is header-ready.
+  uintptr_t span = (((end_addr - total - sizeof(header_s))
+		     & -(uintptr_t)DBL_WORD_SIZE)
+		    + sizeof(header_s));
+  if (span < free_addr) {
+    return NULL;
+  }
+  pb_heap.end_addr = (char*)span;
+  return (char*)span;
+#endif
+
+} // reserve_span ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Record each of a run of blocks just allocated with a single bump as the call
+ * to `malloc()` that it stands in for: at its caller's call site, in the heap
+ * profile, and in the trace, so that a replay or simulation of the trace sees
+ * it allocated before it is freed.  Calls are not timed, since a batch is not
+ * one `malloc()`.  Inlined into each entry point, which is always called from
+ * outside the library, and so finds its caller's return address.
+ *
+ * \param sizes The number of bytes requested for each block, or `NULL` if
+ *              every block asked for `size`.
+ * \param size  The number of bytes requested for every block, if `sizes` is
+ *              `NULL`.
+ * \param out   The blocks.
+ * \param count The number of blocks.
+ */
+__attribute__((always_inline))
+static inline void instrument_batch (const size_t* sizes,
+				     size_t        size,
+				     void**        out,
+				     size_t        count) {
+
+#if defined (PB_SITES) || defined (PB_PROFILE) || defined (PB_TRACE)
+  for (size_t i = 0; i < count; i++) {
+    size_t block_size = sizes != NULL ? sizes[i] : size;
+    COUNT_SITE(block_size);
+    PROFILE_ALLOC(block_size, out[i]);
+    TRACE(PB_TRACE_MALLOC, block_size, out[i], NULL);
+  }
+#endif /* PB_SITES || PB_PROFILE || PB_TRACE */
+
+} // instrument_batch ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate `count` blocks of `size` bytes each with a single bump.
+ *
+ * \param size  The number of bytes in each block.
+ * \param count The number of blocks.
+ * \param out   An array of `count` pointers to fill in with the blocks.
+ * \return      `out`, if successful; `NULL` if unsuccessful.
+ */
+void** pb_malloc_batch (size_t size, size_t count, void** out) {
+
+  // Every block has the same footprint, so the total is a product; refuse one
+  // that overflows or could not possibly fit.
+  size_t stride = block_footprint(size);
+  size_t total;
+  if (size > HEAP_SIZE || __builtin_mul_overflow(stride, count, &total)) {
+    return NULL;
+  }
+
+  init();
+  char* before = malloc_cursor();
+  char* span   = reserve_span(total);
+  if (span == NULL) {
+    return NULL;
+  }
+  count_batch(NULL, size, count, before);
+
+  // Lay the blocks end to end, handing out the space just after each header.
+  // The two loops are kept apart so that the pointers, at least, vectorize.
+  for (size_t i = 0; i < count; i++) {
+    out[i] = span + i * stride + sizeof(header_s);
+  }
+  for (size_t i = 0; i < count; i++) {
+    ((header_s*)(span + i * stride))->size = size;
+  }
+
+  instrument_batch(NULL, size, out, count);
+  PB_PROBE4(malloc_batch, size, count, out, malloc_cursor());
+  return out;
+
+} // pb_malloc_batch ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate `count` blocks of the given `sizes` with a single bump.
+ *
+ * \param sizes The number of bytes in each block.
+ * \param count The number of blocks.
+ * \param out   An array of `count` pointers to fill in with the blocks.
+ * \return      `out`, if successful; `NULL` if unsuccessful.
+ */
+void** pb_malloc_many (const size_t* sizes, size_t count, void** out) {
+
+  // No more blocks than this could fit, however small.
+  if (count > HEAP_SIZE / DBL_WORD_SIZE) {
+    return NULL;
+  }
+
+  // Total the footprints first, so that the heap is bumped once or not at all.
+  // Oversized blocks are caught afterward, keeping this loop free of branches;
+  // with count bounded as above, only they could make the total wrap.
+  size_t total   = 0;
+  size_t largest = 0;
+  for (size_t i = 0; i < count; i++) {
+    total   += block_footprint(sizes[i]);
+    largest  = sizes[i] > largest ? sizes[i] : largest;
+  }
+  if (largest > HEAP_SIZE || total > HEAP_SIZE) {
+    return NULL;
+  }
+
+  init();
+  char* before = malloc_cursor();
+  char* span   = reserve_span(total);
+  if (span == NULL) {
+    return NULL;
+  }
+  count_batch(sizes, 0, count, before);
+
+  // Lay the blocks end to end, writing each header and handing out the space
+  // just after it.
+  for (size_t i = 0; i < count; i++) {
+    header_s* header_ptr = (header_s*)span;
+    header_ptr->size = sizes[i];
+    out[i]           = header_ptr + 1;
+    span            += block_footprint(sizes[i]);
+  }
+
+  instrument_batch(sizes, 0, out, count);
+  PB_PROBE4(malloc_many, sizes, count, out, malloc_cursor());
+  return out;
+
+} // pb_malloc_many ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a struct-of-arrays block with a single raw bump.
+ *
+ * \param columns The columns; each one's `base` is filled in if successful.
+ * \param count   The number of columns.
+ * \param rows    The number of elements in each column.
+ * \param size    Where to store the size of the whole block, if not `NULL`.
+ * \return        The block, if successful; `NULL` if unsuccessful.
+ */
+void* pb_soa_alloc (pb_column_s* columns, size_t count, size_t rows, size_t* size) {
+
+  if (count == 0) {
+    return NULL;
+  }
+
+  // Lay the columns out from offset zero, noting each one's offset in its base
+  // for now.  Keeping the running total within the heap keeps it from wrapping.
+  size_t total   = 0;
+  size_t largest = 1;
+  for (size_t i = 0; i < count; i++) {
+    size_t align = columns[i].align;
+    size_t bytes;
+    if (align == 0 || (align & (align - 1)) != 0 || align > HEAP_SIZE ||
+	__builtin_mul_overflow(columns[i].size, rows, &bytes)) {
+      return NULL;
+    }
+    total = (total + align - 1) & -align;
+    if (bytes > HEAP_SIZE - total) {
+      return NULL;
+    }
+    columns[i].base  = (void*)total;
+    total           += bytes;
+    largest          = align > largest ? align : largest;
+  }
+
+  // The first column is at offset zero, so aligning the block to the largest
+  // alignment aligns every column.
+  char* block = pb_alloc_raw(total, largest);
+  if (block == NULL) {
+    return NULL;
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    columns[i].base = block + (uintptr_t)columns[i].base;
+  }
+  if (size != NULL) {
+    *size = total;
+  }
+  return block;
+
+} // pb_soa_alloc ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Take a snapshot of the heap's accounting.
+ *
+ * \param stats Where to store the snapshot.
+ * \return      `true` if built with `PB_STATS`; `false` if not.
+ */
+bool pb_stats (pb_stats_s* stats) {
+
+#if defined (PB_STATS)
+  *stats = stats_page->stats;
+  stats->padding_bytes = (stats->allocated - stats->requested
+			  - stats->header_bytes);
+  bool counted = true;
+#else
+  memset(stats, 0, sizeof(*stats));
+  bool counted = false;
+#endif /* PB_STATS */
+
+  // Headered blocks grow from one end of the heap and headerless ones from
+  // the other; which is which depends on the direction of bumping.
+  size_t low  = pb_heap.free_addr  - pb_heap.start_addr;
+  size_t high = pb_heap.limit_addr - pb_heap.end_addr;
+  stats->heap_size = pb_heap.limit_addr - pb_heap.start_addr;
+  stats->in_use    = low + high;
+#if !defined (PB_BUMP_DOWN)
+  stats->raw_bytes = high;
+#else
+  stats->raw_bytes = low;
+#endif
+  return counted;
+
+} // pb_stats ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Take a snapshot of the latency histograms.
+ *
+ * \param latency Where to store the snapshot.
+ * \return        `true` if built with `PB_LATENCY` and keeping the histograms;
+ *                `false` if not.
+ */
+bool pb_latency (pb_latency_s* latency) {
+
+#if defined (PB_LATENCY)
+  *latency = latencies;
+  return latencies.period != 0;
+#else
+  memset(latency, 0, sizeof(*latency));
+  return false;
+#endif /* PB_LATENCY */
+
+} // pb_latency ()
+// ==============================================================================
+
+
+
+#if defined (PB_LATENCY)
+// ==============================================================================
+/**
+ * Find a percentile of a latency histogram.
+ *
+ * \param histogram The histogram.
+ * \param total     The calls in it.
+ * \param per_mille The percentile, in thousandths.
+ * \return          The floor of the bucket that holds it.
+ */
+static uint64_t latency_percentile (const uint64_t* histogram,
+				    uint64_t        total,
+				    uint64_t        per_mille) {
+
+  uint64_t rank = total / 1000 * per_mille + (total % 1000 * per_mille + 999) / 1000;
+  uint64_t seen = 0;
+  for (unsigned int bucket = 0; bucket < PB_LATENCY_BUCKETS; bucket++) {
+    seen += histogram[bucket];
+    if (seen >= rank && seen > 0) {
+      return pb_latency_bucket_floor(bucket);
+    }
+  }
+  return 0;
+
+} // latency_percentile ()
+// ==============================================================================
+#endif /* PB_LATENCY */
+
+
+
+// ==============================================================================
+/**
+ * Print the percentiles of each latency histogram, without allocating.  They
+ * are read as they stand, so a dump from a signal handler may miss the call
+ * that the signal interrupted.
+ *
+ * \param fd The file descriptor to write to.
+ */
+void pb_latency_dump (int fd) {
+
+#if defined (PB_LATENCY)
+  if (latencies.period == 0) {
+    return;
+  }
+
+  static const char* names[PB_LATENCY_OPS] = {
+    [PB_LATENCY_MALLOC]  = "malloc  ",
+    [PB_LATENCY_CALLOC]  = "calloc  ",
+    [PB_LATENCY_REALLOC] = "realloc ",
+    [PB_LATENCY_FREE]    = "free    "
+  };
+  static const uint64_t per_mille[] = { 500, 900, 990, 999 };
+
+  safe_puts(fd, "Latency in ticks, 1 in ");
+  safe_putu(fd, latencies.period, 0);
+  safe_puts(fd, " fast calls timed:\n");
+  safe_puts(fd, "                calls       timed     p50     p90     p99   p99.9     max\n");
+  for (int op = 0; op < PB_LATENCY_OPS; op++) {
+    const uint64_t* histogram = latencies.histogram[op];
+    uint64_t        total     = 0;
+    for (unsigned int bucket = 0; bucket < PB_LATENCY_BUCKETS; bucket++) {
+      total += histogram[bucket];
+    }
+    safe_puts(fd, names[op]);
+    safe_putu(fd, total, 13);
+    safe_putu(fd, latencies.timed[op], 12);
+    for (size_t i = 0; i < sizeof(per_mille) / sizeof(per_mille[0]); i++) {
+      safe_putu(fd, latency_percentile(histogram, total, per_mille[i]), 8);
+    }
+    safe_putu(fd, latencies.max[op], 8);
+    safe_puts(fd, "\n");
+  }
+#endif /* PB_LATENCY */
+
+} // pb_latency_dump ()
+// ==============================================================================
+
+
+
+#if defined (PB_PROFILE)
+// ==============================================================================
+/**
+ * Write out the buffered part of the heap profile.
+ *
+ * \param fd The file descriptor to write to.
+ */
+static void profile_flush (int fd) {
+
+  const char* next = profile_out;
+  while (profile_used > 0) {
+    ssize_t written = write(fd, next, profile_used);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    if (written <= 0) {
+      break;
+    }
+    next         += written;
+    profile_used -= written;
+  }
+  profile_used = 0;
+
+} // profile_flush ()
+
+
+
+/**
+ * Append bytes of the heap profile to its buffer, writing the buffer out
+ * whenever it fills.
+ *
+ * \param fd     The file descriptor to write to.
+ * \param bytes  The bytes to append.
+ * \param length The number of bytes.
+ */
+static void profile_put (int fd, const char* bytes, size_t length) {
+
+  while (length > 0) {
+    if (profile_used == PROFILE_OUT_SIZE) {
+      profile_flush(fd);
+    }
+    size_t room  = PROFILE_OUT_SIZE - profile_used;
+    size_t chunk = length < room ? length : room;
+    memcpy(profile_out + profile_used, bytes, chunk);
+    profile_used += chunk;
+    bytes        += chunk;
+    length       -= chunk;
+  }
+
+} // profile_put ()
+
+
+
+/** Append a string to the heap profile. */
+static void profile_puts (int fd, const char* str) {
+  profile_put(fd, str, strlen(str));
+}
+
+
+
+/** Append an unsigned integer to the heap profile, in decimal or, prefixed
+ *  with `0x`, in hexadecimal. */
+static void profile_putu (int fd, uint64_t value, int base) {
+
+  char  digits[24];
+  char* end     = digits + sizeof(digits);
+  char* current = end;
+  do {
+    *--current = "0123456789abcdef"[value % base];
+    value     /= base;
+  } while (value != 0);
+  if (base == 16) {
+    *--current = 'x';
+    *--current = '0';
+  }
+  profile_put(fd, current, end - current);
+
+} // profile_putu ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Append a frame of a collapsed stack: the name of the function that holds the
+ * return address, if it has one; otherwise the object's name and the offset
+ * into it; otherwise, or in a signal handler, the address itself.
+ *
+ * \param fd The file descriptor to write to.
+ * \param pc The return address.
+ */
+static void profile_put_frame (int fd, uintptr_t pc) {
+
+  Dl_info info;
+  if (profile_in_signal ||
+      dladdr((void*)(pc - 1), &info) == 0 || info.dli_fname == NULL) {
+    profile_putu(fd, pc, 16);
+  } else if (info.dli_sname != NULL) {
+    profile_puts(fd, info.dli_sname);
+  } else {
+    const char* slash = strrchr(info.dli_fname, '/');
+    profile_puts(fd, slash != NULL ? slash + 1 : info.dli_fname);
+    profile_puts(fd, "+");
+    profile_putu(fd, pc - (uintptr_t)info.dli_fbase, 16);
+  }
+
+} // profile_put_frame ()
+
+
+
+/**
+ * Append the heap profile as pprof's legacy heap profile: a header with the
+ * totals and the sampling rate, a line per call site of its live and its
+ * allocated samples, in blocks and bytes, and its stack; and the process's
+ * mappings, by which pprof finds the objects to symbolize the stacks with.
+ *
+ * \param fd The file descriptor to write to.
+ */
+static void profile_put_pprof (int fd) {
+
+  uint64_t totals[4] = { 0, 0, 0, 0 };
+  for (size_t i = 0; i < PROFILE_SITES; i++) {
+    totals[0] += profile_sites[i].objects[PROFILE_LIVE];
+    totals[1] += profile_sites[i].bytes[PROFILE_LIVE];
+    totals[2] += profile_sites[i].objects[PROFILE_ALLOCATED];
+    totals[3] += profile_sites[i].bytes[PROFILE_ALLOCATED];
+  }
+
+  const char* separators[] = { "heap profile: ", ": ", " [", ": ", "] @ heap_v2/" };
+  for (int i = 0; i < 4; i++) {
+    profile_puts(fd, separators[i]);
+    profile_putu(fd, totals[i], 10);
+  }
+  profile_puts(fd, separators[4]);
+  profile_putu(fd, profile_rate, 10);
+  profile_puts(fd, "\n");
+
+  for (size_t i = 0; i < PROFILE_SITES; i++) {
+    const profile_site_s* site = &profile_sites[i];
+    if (site->hash == 0) {
+      continue;
+    }
+    uint64_t counts[4] = { site->objects[PROFILE_LIVE], site->bytes[PROFILE_LIVE],
+			   site->objects[PROFILE_ALLOCATED], site->bytes[PROFILE_ALLOCATED] };
+    for (int j = 0; j < 4; j++) {
+      profile_puts(fd, j == 0 ? "" : separators[j]);
+      profile_putu(fd, counts[j], 10);
+    }
+    profile_puts(fd, "] @");
+    for (uint32_t j = 0; j < site->depth; j++) {
+      profile_puts(fd, " ");
+      profile_putu(fd, site->pcs[j], 16);
+    }
+    profile_puts(fd, "\n");
+  }
+
+  profile_puts(fd, "\nMAPPED_LIBRARIES:\n");
+  int maps = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+  if (maps >= 0) {
+    char    buffer[KB(4)];
+    ssize_t got;
+    while ((got = read(maps, buffer, sizeof(buffer))) > 0) {
+      profile_put(fd, buffer, got);
+    }
+    close(maps);
+  }
+
+} // profile_put_pprof ()
+
+
+
+/**
+ * Append the heap profile as collapsed stacks, outermost frame first, each
+ * followed by the estimated bytes of one count at its call site.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param count Which count: `PROFILE_ALLOCATED`, `PROFILE_LIVE` or `PROFILE_DEAD`.
+ */
+static void profile_put_collapsed (int fd, int count) {
+
+  for (size_t i = 0; i < PROFILE_SITES; i++) {
+    const profile_site_s* site = &profile_sites[i];
+    if (site->hash == 0 || site->estimate[count] == 0) {
+      continue;
+    }
+    for (uint32_t j = site->depth; j > 0; j--) {
+      profile_put_frame(fd, site->pcs[j - 1]);
+      profile_puts(fd, j > 1 ? ";" : "");
+    }
+    profile_puts(fd, site->depth > 0 ? " " : "[unknown] ");
+    profile_putu(fd, site->estimate[count], 10);
+    profile_puts(fd, "\n");
+  }
+
+} // profile_put_collapsed ()
+// ==============================================================================
+#endif /* PB_PROFILE */
+
+
+
+// ==============================================================================
+/**
+ * Write the heap profile, without allocating, naming the frames of collapsed
+ * stacks with `dladdr()` unless in the profiler's signal handler.
+ *
+ * \param fd     The file descriptor to write to.
+ * \param format The format in which to write it.
+ * \return       `true` if built with `PB_PROFILE` and profiling; `false` if not.
+ */
+bool pb_profile_dump (int fd, pb_profile_format_e format) {
+
+#if defined (PB_PROFILE)
+  if (profile_sites == NULL) {
+    return false;
+  }
+  if (format == PB_PROFILE_PPROF) {
+    profile_put_pprof(fd);
+  } else {
+    profile_put_collapsed(fd, format - PB_PROFILE_ALLOCATED + PROFILE_ALLOCATED);
+  }
+  profile_flush(fd);
+  return true;
+#else
+  return false;
+#endif /* PB_PROFILE */
+
+} // pb_profile_dump ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Find the call sites that have asked for the most bytes, by insertion into
+ * the sorted list of those found so far.
+ *
+ * \param top   Where to store the sites, busiest first.
+ * \param count The most sites to store.
+ * \return      The number stored; zero unless built with `PB_SITES`.
+ */
+size_t pb_sites (pb_site_s* top, size_t count) {
+
+  size_t found = 0;
+#if defined (PB_SITES)
+  for (size_t i = 0; sites != NULL && i < SITES_TABLE; i++) {
+    pb_site_s site = {
+      .pc    = __atomic_load_n(&sites[i].pc,    __ATOMIC_RELAXED),
+      .calls = __atomic_load_n(&sites[i].calls, __ATOMIC_RELAXED),
+      .bytes = __atomic_load_n(&sites[i].bytes, __ATOMIC_RELAXED)
+    };
+    if (site.pc == 0 || site.calls == 0 ||
+	(found == count && (count == 0 || site.bytes <= top[count - 1].bytes))) {
+      continue;
+    }
+    size_t j = found < count ? found++ : count - 1;
+    for (; j > 0 && top[j - 1].bytes < site.bytes; j--) {
+      top[j] = top[j - 1];
+    }
+    top[j] = site;
+  }
+#endif /* PB_SITES */
+  return found;
+
+} // pb_sites ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Print the call sites that have asked for the most bytes, each with the
+ * function or object that holds it where `dladdr()` can tell, unless in the
+ * site table's signal handler; and then the calls from sites that found the
+ * table full, if any.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param count The most sites to print.
+ */
+void pb_sites_dump (int fd, size_t count) {
+
+#if defined (PB_SITES)
+  if (sites == NULL) {
+    return;
+  }
+
+  pb_site_s top[SITES_TOP_MAX];
+  size_t    found = pb_sites(top, count < SITES_TOP_MAX ? count : SITES_TOP_MAX);
+  safe_puts(fd, "Call sites by bytes requested:\n");
+  safe_puts(fd, "               bytes         calls  site\n");
+  for (size_t i = 0; i < found; i++) {
+    safe_putu(fd, top[i].bytes, 20);
+    safe_putu(fd, top[i].calls, 14);
+    safe_puts(fd, "  ");
+    safe_putx(fd, top[i].pc);
+
+    Dl_info info;
+    if (!sites_in_signal &&
+	dladdr((void*)(top[i].pc - 1), &info) != 0 && info.dli_fname != NULL) {
+      const char* slash = strrchr(info.dli_fname, '/');
+      safe_puts(fd, " ");
+      safe_puts(fd, info.dli_sname != NULL ? info.dli_sname
+		: slash != NULL ? slash + 1 : info.dli_fname);
+      safe_puts(fd, "+");
+      safe_putx(fd, top[i].pc - (uintptr_t)(info.dli_sname != NULL ? info.dli_saddr
+						: info.dli_fbase));
+    }
+    safe_puts(fd, "\n");
+  }
+  if (sites_full.calls != 0) {
+    safe_putu(fd, sites_full.bytes, 20);
+    safe_putu(fd, sites_full.calls, 14);
+    safe_puts(fd, "  (sites beyond the table)\n");
+  }
+#endif /* PB_SITES */
+
+} // pb_sites_dump ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a block from `arena` after the inline fast path failed.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_arena_alloc_slow (pb_arena_s* arena, size_t size) {
+
+  if (arena == &pb_heap) {
+    return pb_malloc_slow(size);
+  }
+  if (size == 0 || size > HEAP_SIZE || !refill_child(arena, block_footprint(size))) {
+    return NULL;
+  }
+  return pb_arena_alloc(arena, size);
+
+} // pb_arena_alloc_slow ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a headerless block from `arena` after the inline fast path failed.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_arena_alloc_raw_slow (pb_arena_s* arena, size_t size, size_t align) {
+
+  if (arena == &pb_heap) {
+    return pb_alloc_raw_slow(size, align);
+  }
+  // The block needs its size and, at worst, all but one byte of its alignment
+  // from the new chunk; neither is past HEAP_SIZE, so the sum cannot wrap.
+  if (size > HEAP_SIZE || align == 0 || (align & (align - 1)) != 0 ||
+      align > HEAP_SIZE || !refill_child(arena, size + align - 1)) {
+    return NULL;
+  }
+  return pb_arena_alloc_raw(arena, size, align);
+
+} // pb_arena_alloc_raw_slow ()
 // ==============================================================================
 
 
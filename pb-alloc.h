@@ -0,0 +1,990 @@
+// ==============================================================================
+/**
+ * pb-alloc.h
+ *
+ * The public interface to the _pointer-bumping_ allocator, for code that links
+ * against it directly rather than merely interposing on `malloc()`.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_ALLOC_H)
+#define _PB_ALLOC_H
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+// ==============================================================================
+
+
+
+// ==============================================================================
+// C linkage for C++ callers.
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** The alignment of every block returned by `malloc()`. */
+#define PB_ALIGNMENT 16
+
+/** The largest request that the fast paths will consider. */
+#define PB_MAX_SIZE ((size_t)PTRDIFF_MAX)
+
+/** Hint that a condition is almost never true. */
+#define PB_UNLIKELY(cond) __builtin_expect(!!(cond), 0)
+
+/**
+ * Latency histograms (see `pb_latency()`) are log-linear: exact below
+ * `2 * PB_LATENCY_SUB_BUCKETS` ticks, and in `PB_LATENCY_SUB_BUCKETS` steps per
+ * power of two above, so that every bucket is within an eighth of its floor.
+ */
+#define PB_LATENCY_SUB_BITS    3
+#define PB_LATENCY_SUB_BUCKETS (1 << PB_LATENCY_SUB_BITS)
+#define PB_LATENCY_BUCKETS     (2 * PB_LATENCY_SUB_BUCKETS +			\
+				(64 - PB_LATENCY_SUB_BITS - 1) * PB_LATENCY_SUB_BUCKETS)
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** A header for each block's metadata, placed just before the block. */
+typedef struct pb_header {
+
+  /** The size of the useful portion of the block, in bytes. */
+  size_t size;
+
+} pb_header_s;
+
+/**
+ * A bump region.  Blocks with headers (those from `malloc()`) are carved upward
+ * from `free_addr`; headerless blocks (those from `pb_alloc_raw()`) are carved
+ * downward from `end_addr`.  The region is exhausted when the two meet.  When
+ * built with `PB_BUMP_DOWN`, the two kinds of block trade ends.
+ *
+ * An arena may be the child of another, in which case its region is the
+ * newest of a chain of chunks carved from its parent as it fills.
+ *
+ * The cursors are pointers rather than integers so that the compiler knows a
+ * header store cannot overwrite them, and so can keep them in registers across
+ * a loop of inlined allocations.
+ */
+typedef struct pb_arena {
+
+  /** The address of the lowest available byte. */
+  char* free_addr;
+
+  /** One past the address of the highest available byte. */
+  char* end_addr;
+
+  /** The bounds of the whole region, to which the cursors are reset. */
+  char* start_addr;
+  char* limit_addr;
+
+  /**
+   * For a child arena, the arena from which its chunks are carved, the newest
+   * of those chunks (whose bounds are the region's), and the size of the next.
+   */
+  struct pb_arena* parent;
+  struct pb_chunk* chunks;
+  size_t           chunk_size;
+
+  /** This arena's children, and its neighbours among its parent's children. */
+  struct pb_arena* first_child;
+  struct pb_arena* prev_sibling;
+  struct pb_arena* next_sibling;
+
+} pb_arena_s;
+
+/**
+ * The state of an arena's cursors at some moment, so that everything allocated
+ * from it since then can be released at once.
+ */
+typedef struct pb_mark {
+
+  char* free_addr;
+  char* end_addr;
+
+} pb_mark_s;
+
+/**
+ * One column of a struct-of-arrays block, for `pb_soa_alloc()`.  The caller
+ * describes the column's elements; the allocation fills in where it begins.
+ */
+typedef struct pb_column {
+
+  /** The number of bytes in each element of the column. */
+  size_t size;
+
+  /** The alignment of the column's start; must be a power of two. */
+  size_t align;
+
+  /** The column's first element, once allocated. */
+  void*  base;
+
+} pb_column_s;
+
+/**
+ * A snapshot of the heap's accounting, from `pb_stats()`.  The space in use is
+ * read from the cursors, and so covers every path, inline ones included.  The
+ * rest is counted by the library's own entry points, and only in a build with
+ * `PB_STATS` defined; the byte counts cover the blocks from `malloc()` (and so
+ * `calloc()` and `realloc()`), and from `pb_malloc_batch()` and
+ * `pb_malloc_many()`, each of whose blocks counts as a call to `malloc()`, that
+ * have not been reclaimed.
+ */
+typedef struct pb_stats {
+
+  /** The bytes reserved for the heap, and those consumed from it so far. */
+  size_t heap_size;
+  size_t in_use;
+
+  /** Of those in use, the bytes taken by headerless blocks. */
+  size_t raw_bytes;
+
+  /** The most bytes in use at the end of any call to `malloc()`. */
+  size_t peak;
+
+  /** The bytes asked for, and the bytes consumed from the heap to supply them. */
+  size_t requested;
+  size_t allocated;
+
+  /** Of those allocated, the bytes taken by headers and by alignment. */
+  size_t header_bytes;
+  size_t padding_bytes;
+
+  /** Of those allocated, the bytes freed but never reclaimed. */
+  size_t dead_bytes;
+
+  /** Calls to each entry point, counting those that `calloc()` and `realloc()`
+   *  make to `malloc()` and `free()`. */
+  size_t malloc_calls;
+  size_t free_calls;
+  size_t calloc_calls;
+  size_t realloc_calls;
+
+} pb_stats_s;
+
+/** The entry points whose latencies are measured, indexing `pb_latency_s`. */
+typedef enum pb_latency_op {
+
+  PB_LATENCY_MALLOC,
+  PB_LATENCY_CALLOC,
+  PB_LATENCY_REALLOC,
+  PB_LATENCY_FREE,
+  PB_LATENCY_OPS
+
+} pb_latency_op_e;
+
+/**
+ * A snapshot of the latency histograms, from `pb_latency()`, in ticks of the
+ * timestamp counter.  Calls that take a slow path are always timed, and each
+ * counts once; of the rest, one in `period` is timed, and counts `period`
+ * times, so that each histogram estimates every call to its entry point,
+ * including those that `calloc()` and `realloc()` make to `malloc()` and
+ * `free()`.
+ */
+typedef struct pb_latency {
+
+  /** The calls on fast paths per one timed. */
+  uint64_t period;
+
+  /** For each entry point, the calls timed, and the longest of them. */
+  uint64_t timed[PB_LATENCY_OPS];
+  uint64_t max[PB_LATENCY_OPS];
+
+  /** For each entry point, the estimated calls in each bucket. */
+  uint64_t histogram[PB_LATENCY_OPS][PB_LATENCY_BUCKETS];
+
+} pb_latency_s;
+
+/**
+ * The formats in which `pb_profile_dump()` writes the heap profile: pprof's
+ * legacy heap profile, with the sampled counts that pprof scales up itself;
+ * or collapsed stacks (one `root;...;leaf bytes` line per call site, as
+ * flame graph tools read them) of the estimated bytes allocated, of those
+ * still live, or of those freed but never reclaimed, and so still resident.
+ */
+typedef enum pb_profile_format {
+
+  PB_PROFILE_PPROF,
+  PB_PROFILE_ALLOCATED,
+  PB_PROFILE_LIVE,
+  PB_PROFILE_DEAD
+
+} pb_profile_format_e;
+
+/** A call site of `malloc()`, `calloc()` or `realloc()`, from `pb_sites()`. */
+typedef struct pb_site {
+
+  /** The caller's return address. */
+  uintptr_t pc;
+
+  /** The calls made from there, and the bytes that they asked for. */
+  uint64_t  calls;
+  uint64_t  bytes;
+
+} pb_site_s;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/**
+ * The cursors of the heap itself.  Both are zero until the heap is initialized,
+ * which makes every fast path below fall through to its out-of-line slow path.
+ */
+extern pb_arena_s pb_heap;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// FUNCTIONS
+
+#if !defined (PB_BUMP_DOWN)
+/**
+ * Carve a block of `size` bytes, with a header, out of `arena`.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \return      A pointer to the allocated block, if it fits; `NULL` if it does
+ *              not, or if `size` is zero.
+ */
+static inline void* pb_arena_alloc (pb_arena_s* arena, size_t size) {
+
+  // The cursor is always just short of an aligned address by the size of the
+  // header, so rounding the header and block up keeps it there.  The first
+  // comparison rejects zero and anything large enough to wrap the sum below.
+  char*     header   = arena->free_addr;
+  size_t    total    = ((size + sizeof(pb_header_s) + PB_ALIGNMENT - 1)
+			& -(size_t)PB_ALIGNMENT);
+  uintptr_t new_free = (uintptr_t)header + total;
+  if (PB_UNLIKELY((size - 1 >= PB_MAX_SIZE)
+		  | (new_free > (uintptr_t)arena->end_addr))) {
+    return NULL;
+  }
+
+  arena->free_addr = (char*)new_free;
+  ((pb_header_s*)header)->size = size;
+  return header + sizeof(pb_header_s);
+
+} // pb_arena_alloc ()
+
+
+
+/**
+ * Carve a headerless block of `size` bytes, aligned to `align`, out of `arena`.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if it fits; `NULL` if not.
+ */
+static inline void* pb_arena_alloc_raw (pb_arena_s* arena,
+					size_t      size,
+					size_t      align) {
+
+  // Bump downward and align down with a mask.  The first comparison keeps the
+  // subtraction from wrapping; the second catches the slack lost to alignment.
+  uintptr_t free_addr = (uintptr_t)arena->free_addr;
+  uintptr_t end_addr  = (uintptr_t)arena->end_addr;
+  uintptr_t block     = (end_addr - size) & -(uintptr_t)align;
+  if (PB_UNLIKELY((size > end_addr - free_addr) | (block < free_addr))) {
+    return NULL;
+  }
+
+  arena->end_addr = (char*)block;
+  return (void*)block;
+
+} // pb_arena_alloc_raw ()
+
+
+
+/**
+ * Hand a block back to `arena` if it was the last one carved from the bottom;
+ * otherwise it stays where it is.  The caller supplies the block's size, which
+ * saves reading its header.
+ *
+ * \param arena The region that the block came from.
+ * \param ptr   A block from `pb_arena_alloc()`.
+ * \param size  The size with which the block was allocated.
+ */
+static inline void pb_arena_free_sized (pb_arena_s* arena, void* ptr, size_t size) {
+
+  char*  header = (char*)ptr - sizeof(pb_header_s);
+  size_t total  = ((size + sizeof(pb_header_s) + PB_ALIGNMENT - 1)
+		   & -(size_t)PB_ALIGNMENT);
+  if (header + total == arena->free_addr) {
+    arena->free_addr = header;
+  }
+
+} // pb_arena_free_sized ()
+
+
+
+/**
+ * Hand a headerless block back to `arena` if it was the last one carved from
+ * the top; otherwise it stays where it is.  Any slack lost to aligning the
+ * block stays behind with it; see `pb_raw_footprint()`.
+ *
+ * \param arena The region that the block came from.
+ * \param ptr   A block from `pb_arena_alloc_raw()`.
+ * \param size  The size with which the block was allocated.
+ */
+static inline void pb_arena_free_raw (pb_arena_s* arena, void* ptr, size_t size) {
+
+  if ((char*)ptr == arena->end_addr) {
+    arena->end_addr = (char*)ptr + size;
+  }
+
+} // pb_arena_free_raw ()
+#else
+/**
+ * Carve a block of `size` bytes, with a header, out of `arena`.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \return      A pointer to the allocated block, if it fits; `NULL` if it does
+ *              not, or if `size` is zero.
+ */
+static inline void* pb_arena_alloc (pb_arena_s* arena, size_t size) {
+
+  // Bump downward and align down with a mask, leaving the header just below.
+  // The second comparison measures what the block consumed from the top, so
+  // it fails for a block that fell below free_addr or wrapped past zero.
+  uintptr_t free_addr = (uintptr_t)arena->free_addr;
+  uintptr_t end_addr  = (uintptr_t)arena->end_addr;
+  uintptr_t block     = (end_addr - size) & -(uintptr_t)PB_ALIGNMENT;
+  uintptr_t header    = block - sizeof(pb_header_s);
+  if (PB_UNLIKELY((size - 1 >= PB_MAX_SIZE)
+		  | (end_addr - header > end_addr - free_addr))) {
+    return NULL;
+  }
+
+  arena->end_addr = (char*)header;
+  ((pb_header_s*)header)->size = size;
+  return (void*)block;
+
+} // pb_arena_alloc ()
+
+
+
+/**
+ * Carve a headerless block of `size` bytes, aligned to `align`, out of `arena`.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if it fits; `NULL` if not.
+ */
+static inline void* pb_arena_alloc_raw (pb_arena_s* arena,
+					size_t      size,
+					size_t      align) {
+
+  // Align up with a mask and bump upward.  The first comparison keeps the sum
+  // from wrapping; the second catches the slack lost to alignment.
+  uintptr_t free_addr = (uintptr_t)arena->free_addr;
+  uintptr_t end_addr  = (uintptr_t)arena->end_addr;
+  uintptr_t block     = (free_addr + align - 1) & -(uintptr_t)align;
+  uintptr_t new_free  = block + size;
+  if (PB_UNLIKELY((size > end_addr - free_addr) | (new_free > end_addr))) {
+    return NULL;
+  }
+
+  arena->free_addr = (char*)new_free;
+  return (void*)block;
+
+} // pb_arena_alloc_raw ()
+
+
+
+/**
+ * Hand a block back to `arena` if it was the last one carved from the top;
+ * otherwise it stays where it is.  The caller supplies the block's size, which
+ * saves reading its header.
+ *
+ * \param arena The region that the block came from.
+ * \param ptr   A block from `pb_arena_alloc()`.
+ * \param size  The size with which the block was allocated.
+ */
+static inline void pb_arena_free_sized (pb_arena_s* arena, void* ptr, size_t size) {
+
+  // The cursor is kept just above an aligned address by the size of a header,
+  // so the block consumed exactly its rounded-up footprint.
+  char*  header = (char*)ptr - sizeof(pb_header_s);
+  size_t total  = ((size + sizeof(pb_header_s) + PB_ALIGNMENT - 1)
+		   & -(size_t)PB_ALIGNMENT);
+  if (header == arena->end_addr) {
+    arena->end_addr = header + total;
+  }
+
+} // pb_arena_free_sized ()
+
+
+
+/**
+ * Hand a headerless block back to `arena` if it was the last one carved from
+ * the bottom; otherwise it stays where it is.  Any slack lost to aligning the
+ * block stays behind with it; see `pb_raw_footprint()`.
+ *
+ * \param arena The region that the block came from.
+ * \param ptr   A block from `pb_arena_alloc_raw()`.
+ * \param size  The size with which the block was allocated.
+ */
+static inline void pb_arena_free_raw (pb_arena_s* arena, void* ptr, size_t size) {
+
+  if ((char*)ptr + size == arena->free_addr) {
+    arena->free_addr = (char*)ptr;
+  }
+
+} // pb_arena_free_raw ()
+#endif /* PB_BUMP_DOWN */
+
+
+
+/**
+ * Hand a block back to `arena` if it was the last one allocated from it;
+ * otherwise it stays where it is.  This is what `free()` does.
+ *
+ * \param arena The region that the block came from.
+ * \param ptr   A block from `pb_arena_alloc()`.
+ */
+static inline void pb_arena_free (pb_arena_s* arena, void* ptr) {
+
+  pb_arena_free_sized(arena, ptr, ((pb_header_s*)ptr)[-1].size);
+
+} // pb_arena_free ()
+
+
+
+/**
+ * Note the state of `arena`, to be returned to with `pb_arena_rewind()`.
+ *
+ * \param arena The region to mark.
+ * \return      The mark.
+ */
+static inline pb_mark_s pb_arena_mark (const pb_arena_s* arena) {
+
+  pb_mark_s mark = { arena->free_addr, arena->end_addr };
+  return mark;
+
+} // pb_arena_mark ()
+
+
+
+/**
+ * Release everything allocated from `arena`, at either end, since `mark` was
+ * taken.  Marks taken later than `mark` become invalid.  A child arena keeps
+ * any chunks it has carved since the mark until it is reset.
+ *
+ * \param arena The region to rewind.
+ * \param mark  A mark previously taken on `arena`.
+ */
+static inline void pb_arena_rewind (pb_arena_s* arena, pb_mark_s mark) {
+
+  arena->free_addr = mark.free_addr;
+  arena->end_addr  = mark.end_addr;
+
+} // pb_arena_rewind ()
+
+
+
+/**
+ * The size to carve for a headerless block that is to be handed back in LIFO
+ * order.  Raw blocks are carved to the byte, so that strings and the like pack
+ * densely; but a block of odd size leaves the raw cursor unaligned, and the
+ * next block aligned past it cannot give that slack back when freed.  Rounding
+ * every such block up to `PB_ALIGNMENT` keeps the cursor on that boundary,
+ * where it starts, so that any block aligned no more strictly is carved with no
+ * slack and freeing it restores the cursor exactly.  The adapters in the C++
+ * headers carve and free with this size.
+ *
+ * \param size The number of bytes wanted.
+ * \return     `size` rounded up to `PB_ALIGNMENT`, or `size` itself if that is
+ *             too large for any arena, so that the rounding cannot wrap.
+ */
+static inline size_t pb_raw_footprint (size_t size) {
+
+  if (PB_UNLIKELY(size > PB_MAX_SIZE)) {
+    return size;
+  }
+  return (size + PB_ALIGNMENT - 1) & -(size_t)PB_ALIGNMENT;
+
+} // pb_raw_footprint ()
+
+
+
+/**
+ * The out-of-line half of `pb_arena_alloc()`, for callers that would rather not
+ * give up as soon as `arena` is full.  For the heap itself, this is
+ * `pb_malloc_slow()`; a child arena carves a new chunk from its parent and
+ * retries; other arenas simply fail.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_arena_alloc_slow (pb_arena_s* arena, size_t size);
+
+
+
+/**
+ * The out-of-line half of `pb_arena_alloc_raw()`, for callers that would
+ * rather not give up as soon as `arena` is full.  For the heap itself, this is
+ * `pb_alloc_raw_slow()`; a child arena carves a new chunk from its parent and
+ * retries; other arenas simply fail.
+ *
+ * \param arena The region to allocate from.
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_arena_alloc_raw_slow (pb_arena_s* arena, size_t size, size_t align);
+
+
+
+/**
+ * Make `arena` a region over the `size` bytes at `buffer`, which it does not
+ * own.
+ *
+ * \param arena  The arena to initialize.
+ * \param buffer The memory to allocate from.
+ * \param size   The number of bytes at `buffer`.
+ * \return       `true` if successful; `false` if the buffer is too small to hold
+ *               any block.
+ */
+bool pb_arena_init_buffer (pb_arena_s* arena, void* buffer, size_t size);
+
+
+
+/**
+ * Make `arena` a region of `capacity` bytes carved from the heap, much as a
+ * headerless block is.
+ *
+ * \param arena    The arena to initialize.
+ * \param capacity The number of bytes in the region.
+ * \return         `true` if successful; `false` if unsuccessful.
+ */
+bool pb_arena_init (pb_arena_s* arena, size_t capacity);
+
+
+
+/**
+ * Make `child` an empty arena whose region is carved from `parent`, a chunk at
+ * a time, as it is needed.  Chunks start at `chunk_size` bytes (or a page,
+ * if that is larger) and double as the child fills, but are never smaller
+ * than the request that needs them.  Allocation from the child is the same
+ * pointer bump as from any arena; only refilling it involves the parent.
+ *
+ * \param child      The arena to initialize.
+ * \param parent     The arena to carve chunks from; the heap itself, or any
+ *                   other arena, including another child.
+ * \param chunk_size The size of the first chunk.
+ */
+void pb_arena_init_child (pb_arena_s* child, pb_arena_s* parent, size_t chunk_size);
+
+
+
+/**
+ * Release everything allocated from `arena`.  A child arena hands its chunks
+ * back to its parent.  Every arena below `arena` is emptied too, since its
+ * chunks came from memory that is now free; it remains a child, and carves
+ * new chunks when next used.
+ *
+ * \param arena The region to reset.
+ */
+void pb_arena_reset (pb_arena_s* arena);
+
+
+
+/**
+ * Release an arena made by `pb_arena_init()` or `pb_arena_init_child()`,
+ * handing its region or chunks back to wherever they came from, if nothing has
+ * been allocated from there since.  Any children are destroyed first.
+ *
+ * \param arena The arena to destroy.
+ */
+void pb_arena_destroy (pb_arena_s* arena);
+
+
+
+/**
+ * The out-of-line half of `pb_malloc()`: initialize the heap if needed and
+ * retry, or fail.
+ *
+ * \param size The number of bytes to allocate.
+ * \return     A pointer to the allocated block, if successful; `NULL` if
+ *             unsuccessful.
+ */
+void* pb_malloc_slow (size_t size);
+
+
+
+/**
+ * Allocate `size` bytes exactly as `malloc()` does, header and all, but inline
+ * in the caller.  Blocks from either may be passed to `free()` or `realloc()`.
+ * Compiled with `PB_STATS`, to match a library built with it, this calls into
+ * the library every time, so that the block is counted; a block from the
+ * inline bump is not, and freeing it takes nothing from the counts.
+ *
+ * \param size The number of bytes to allocate.
+ * \return     A pointer to the allocated block, if successful; `NULL` if
+ *             unsuccessful.
+ */
+static inline void* pb_malloc (size_t size) {
+
+#if defined (PB_STATS)
+  return pb_malloc_slow(size);
+#else
+  void* block = pb_arena_alloc(&pb_heap, size);
+  if (PB_UNLIKELY(block == NULL)) {
+    return pb_malloc_slow(size);
+  }
+  return block;
+#endif /* PB_STATS */
+
+} // pb_malloc ()
+
+
+
+/**
+ * The out-of-line half of `pb_alloc_raw()`: initialize the heap if needed and
+ * retry, validating `align` along the way.
+ *
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+void* pb_alloc_raw_slow (size_t size, size_t align);
+
+
+
+/**
+ * Allocate `size` bytes aligned to exactly `align` without any header.  Such
+ * blocks can never be passed to `free()` or `realloc()`; they live as long as
+ * the heap does, unless handed straight back with `pb_free_raw()`.  A zero-byte
+ * request may return `NULL`.
+ *
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment; must be a power of two.
+ * \return      A pointer to the allocated block, if successful; `NULL` if
+ *              unsuccessful.
+ */
+static inline void* pb_alloc_raw (size_t size, size_t align) {
+
+  void* block = pb_arena_alloc_raw(&pb_heap, size, align);
+  if (PB_UNLIKELY(block == NULL)) {
+    return pb_alloc_raw_slow(size, align);
+  }
+  return block;
+
+} // pb_alloc_raw ()
+
+
+
+/**
+ * Allocate `count` blocks of `size` bytes each, as if by `count` calls to
+ * `malloc()`, but with a single bump of the heap.  Each block has its own
+ * header and may be passed to `free()` or `realloc()` individually.  A zero
+ * `size` yields distinct blocks with no usable space.  Each block is counted,
+ * traced, profiled and attributed to the caller as a call to `malloc()` would
+ * be, but the call is not timed in the latency histograms.
+ *
+ * \param size  The number of bytes in each block.
+ * \param count The number of blocks.
+ * \param out   An array of `count` pointers to fill in with the blocks.
+ * \return      `out`, if successful; `NULL` if unsuccessful, in which case
+ *              nothing was allocated.
+ */
+void** pb_malloc_batch (size_t size, size_t count, void** out);
+
+
+
+/**
+ * Allocate `count` blocks whose sizes are given by `sizes`, as if by `count`
+ * calls to `malloc()`, but with a single bump of the heap, in the manner of
+ * dlmalloc's `independent_comalloc()`.  As with `pb_malloc_batch()`, each
+ * block may be freed or resized on its own, and is instrumented as a call to
+ * `malloc()`.
+ *
+ * \param sizes The number of bytes in each block.
+ * \param count The number of blocks.
+ * \param out   An array of `count` pointers to fill in with the blocks.
+ * \return      `out`, if successful; `NULL` if unsuccessful, in which case
+ *              nothing was allocated.
+ */
+void** pb_malloc_many (const size_t* sizes, size_t count, void** out);
+
+
+
+/**
+ * Allocate a struct-of-arrays block: `count` columns of `rows` elements each,
+ * laid end to end in the order given, each starting at its own alignment, all
+ * in a single headerless block.  The block begins with the first column, and
+ * may be handed back with `pb_free_raw()` given the size stored in `size`.
+ *
+ * \param columns The columns; each one's `base` is filled in if successful.
+ * \param count   The number of columns.
+ * \param rows    The number of elements in each column.
+ * \param size    Where to store the size of the whole block, if not `NULL`.
+ * \return        The block, if successful; `NULL` if unsuccessful, in which
+ *                case nothing was allocated.
+ */
+void* pb_soa_alloc (pb_column_s* columns, size_t count, size_t rows, size_t* size);
+
+
+
+/**
+ * Take a snapshot of the heap's accounting.
+ *
+ * \param stats Where to store the snapshot.
+ * \return      `true` if the library was built with `PB_STATS`; `false` if not,
+ *              in which case only the fields read from the cursors are filled
+ *              in, and the rest are zero.
+ */
+bool pb_stats (pb_stats_s* stats);
+
+
+
+/**
+ * Take a snapshot of the latency histograms.  They are kept only by a library
+ * built with `PB_LATENCY`, and run with `PB_LATENCY` in its environment set to
+ * the sampling period (e.g., `64`, or `1` to time every call).
+ *
+ * \param latency Where to store the snapshot.
+ * \return        `true` if the histograms are kept; `false` if not, in which
+ *                case the snapshot is all zero.
+ */
+bool pb_latency (pb_latency_s* latency);
+
+
+
+/**
+ * Print the percentiles of each latency histogram to `fd`, without allocating,
+ * so that this may be called from a signal handler.  Prints nothing unless the
+ * histograms are kept (see `pb_latency()`).
+ *
+ * \param fd The file descriptor to write to.
+ */
+void pb_latency_dump (int fd);
+
+
+
+/**
+ * Write the heap profile to `fd`, without allocating.  The profile is kept
+ * only by a library built with `PB_PROFILE`, and run with `PB_PROFILE_FILE`
+ * in its environment naming the file to which it is written at exit.
+ *
+ * Collapsed stacks name their frames with `dladdr()`, which is not
+ * async-signal-safe, so this must not be called from a signal handler.  The
+ * library's own handler, for `PB_PROFILE_SIGNAL`, writes each frame as its
+ * bare address instead; pprof's format carries only addresses and the
+ * process's mappings in any case, and pprof names the frames offline.
+ *
+ * \param fd     The file descriptor to write to.
+ * \param format The format in which to write it.
+ * \return       `true` if the profile is kept; `false` if not, in which case
+ *               nothing is written.
+ */
+bool pb_profile_dump (int fd, pb_profile_format_e format);
+
+
+
+/**
+ * Find the call sites that have asked for the most bytes.  Sites are counted
+ * only by a library built with `PB_SITES`, by the return address of each call
+ * to `malloc()`, `calloc()` and `realloc()` from outside the library.
+ *
+ * \param top   Where to store the sites, busiest first.
+ * \param count The most sites to store.
+ * \return      The number of sites stored; zero if none are counted.
+ */
+size_t pb_sites (pb_site_s* top, size_t count);
+
+
+
+/**
+ * Print the call sites that have asked for the most bytes to `fd`, without
+ * allocating.  Prints nothing unless sites are counted (see `pb_sites()`).
+ *
+ * Each site is named with `dladdr()`, which is not async-signal-safe, so this
+ * must not be called from a signal handler.  The library's own handler, for
+ * `PB_SITES_SIGNAL`, prints the sites' addresses alone instead.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param count The most sites to print; no more than 256 are.
+ */
+void pb_sites_dump (int fd, size_t count);
+
+
+
+/**
+ * The bucket of a latency histogram (see `pb_latency_s`) that holds `ticks`.
+ *
+ * \param ticks The latency.
+ * \return      The bucket.
+ */
+static inline unsigned int pb_latency_bucket (uint64_t ticks) {
+
+  if (ticks < 2 * PB_LATENCY_SUB_BUCKETS) {
+    return ticks;
+  }
+  unsigned int exponent = 63 - __builtin_clzll(ticks);
+  return (2 * PB_LATENCY_SUB_BUCKETS
+	  + (exponent - PB_LATENCY_SUB_BITS - 1) * PB_LATENCY_SUB_BUCKETS
+	  + ((ticks >> (exponent - PB_LATENCY_SUB_BITS)) & (PB_LATENCY_SUB_BUCKETS - 1)));
+
+} // pb_latency_bucket ()
+
+
+
+/**
+ * The smallest latency in a bucket of a latency histogram.
+ *
+ * \param bucket The bucket.
+ * \return       The latency, in ticks.
+ */
+static inline uint64_t pb_latency_bucket_floor (unsigned int bucket) {
+
+  if (bucket < 2 * PB_LATENCY_SUB_BUCKETS) {
+    return bucket;
+  }
+  unsigned int exponent = ((bucket - 2 * PB_LATENCY_SUB_BUCKETS) / PB_LATENCY_SUB_BUCKETS
+			   + PB_LATENCY_SUB_BITS + 1);
+  uint64_t     sub      = (bucket - 2 * PB_LATENCY_SUB_BUCKETS) % PB_LATENCY_SUB_BUCKETS;
+  return (1ULL << exponent) + (sub << (exponent - PB_LATENCY_SUB_BITS));
+
+} // pb_latency_bucket_floor ()
+
+
+
+/**
+ * Free a block from `malloc()` whose size the caller knows, as C23's
+ * `free_sized()` does.  Only the block at the top of the heap is reclaimed,
+ * and knowing its size saves reading its header to find out.
+ *
+ * \param ptr  A block from `malloc()`, or `NULL`.
+ * \param size The size with which the block was allocated.
+ */
+static inline void pb_free_sized (void* ptr, size_t size) {
+
+  if (ptr != NULL) {
+    pb_arena_free_sized(&pb_heap, ptr, size);
+  }
+
+} // pb_free_sized ()
+
+
+
+/**
+ * Hand a headerless block back to the heap if it was the last one allocated.
+ *
+ * \param ptr  A block from `pb_alloc_raw()`.
+ * \param size The size with which the block was allocated.
+ */
+static inline void pb_free_raw (void* ptr, size_t size) {
+
+  pb_arena_free_raw(&pb_heap, ptr, size);
+
+} // pb_free_raw ()
+
+
+
+/**
+ * Copy `size` bytes from `src` into a new headerless block that is aligned as
+ * `malloc()` would align it.
+ *
+ * \param src  The bytes to copy.
+ * \param size The number of bytes to copy.
+ * \return     A pointer to the copy, if successful; `NULL` if unsuccessful.
+ */
+static inline void* pb_memdup (const void* src, size_t size) {
+
+  void* copy = pb_alloc_raw(size, PB_ALIGNMENT);
+  if (copy != NULL) {
+    memcpy(copy, src, size);
+  }
+  return copy;
+
+} // pb_memdup ()
+
+
+
+/**
+ * Copy at most `n` characters of `str` into a new, null-terminated, headerless
+ * and unaligned block.
+ *
+ * \param str The string to copy.
+ * \param n   The maximum number of characters to copy.
+ * \return    A pointer to the copy, if successful; `NULL` if unsuccessful.
+ */
+static inline char* pb_strndup (const char* str, size_t n) {
+
+  size_t length = strnlen(str, n);
+  char*  copy   = (char*)pb_alloc_raw(length + 1, 1);
+  if (copy != NULL) {
+    memcpy(copy, str, length);
+    copy[length] = '\0';
+  }
+  return copy;
+
+} // pb_strndup ()
+
+
+
+/**
+ * Copy `str` into a new headerless and unaligned block.
+ *
+ * \param str The string to copy.
+ * \return    A pointer to the copy, if successful; `NULL` if unsuccessful.
+ */
+static inline char* pb_strdup (const char* str) {
+
+  size_t size = strlen(str) + 1;
+  char*  copy = (char*)pb_alloc_raw(size, 1);
+  if (copy != NULL) {
+    memcpy(copy, str, size);
+  }
+  return copy;
+
+} // pb_strdup ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+#if defined (__cplusplus)
+}
+#endif
+// ==============================================================================
+
+
+
+// ==============================================================================
+#endif // _PB_ALLOC_H
+// ==============================================================================
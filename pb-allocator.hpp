@@ -0,0 +1,127 @@
+// ==============================================================================
+/**
+ * pb-allocator.hpp
+ *
+ * An STL allocator that bumps through an arena of the _pointer-bumping_ heap.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_ALLOCATOR_HPP)
+#define _PB_ALLOCATOR_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * A stateful allocator bound to a pb arena (the heap itself, by default).
+ * Allocation is an inline, header-free pointer bump of whole multiples of
+ * `PB_ALIGNMENT`; deallocation hands the block back only if it was the last one
+ * allocated from the arena, as `free()` does.
+ *
+ * Containers that are moved or swapped take their arena with them, so that
+ * neither costs more than swapping pointers; a copy-assigned container keeps
+ * its own arena and copies the elements into it.
+ */
+template <typename T>
+class bump_allocator {
+
+public:
+
+  using value_type                             = T;
+  using size_type                              = std::size_t;
+  using difference_type                        = std::ptrdiff_t;
+  using propagate_on_container_copy_assignment = std::false_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap            = std::true_type;
+  using is_always_equal                        = std::false_type;
+
+  /** Allocate from the heap itself. */
+  bump_allocator () noexcept
+    : arena_(&pb_heap) {}
+
+  /** Allocate from `arena`, which must outlive every container using it. */
+  explicit bump_allocator (pb_arena_s* arena) noexcept
+    : arena_(arena) {}
+
+  template <typename U>
+  bump_allocator (const bump_allocator<U>& other) noexcept
+    : arena_(other.arena()) {}
+
+  /** \return The arena allocated from. */
+  pb_arena_s* arena () const noexcept {
+    return arena_;
+  }
+
+  T* allocate (size_type count) {
+
+    if (PB_UNLIKELY(count > PB_MAX_SIZE / sizeof(T))) {
+      throw std::bad_array_new_length();
+    }
+
+    size_type size  = pb_raw_footprint(count * sizeof(T));
+    void*     block = pb_arena_alloc_raw(arena_, size, alignof(T));
+    if (PB_UNLIKELY(block == nullptr)) {
+      block = pb_arena_alloc_raw_slow(arena_, size, alignof(T));
+      if (block == nullptr) {
+	throw std::bad_alloc();
+      }
+    }
+    return static_cast<T*>(block);
+
+  }
+
+  void deallocate (T* block, size_type count) noexcept {
+
+    pb_arena_free_raw(arena_, block, pb_raw_footprint(count * sizeof(T)));
+
+  }
+
+private:
+
+  /** The arena allocated from. */
+  pb_arena_s* arena_;
+
+}; // class bump_allocator
+// ==============================================================================
+
+
+
+// ==============================================================================
+template <typename T, typename U>
+bool operator== (const bump_allocator<T>& a, const bump_allocator<U>& b) noexcept {
+  return a.arena() == b.arena();
+}
+
+template <typename T, typename U>
+bool operator!= (const bump_allocator<T>& a, const bump_allocator<U>& b) noexcept {
+  return a.arena() != b.arena();
+}
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_ALLOCATOR_HPP
+// ==============================================================================
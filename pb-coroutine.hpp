@@ -0,0 +1,164 @@
+// ==============================================================================
+/**
+ * pb-coroutine.hpp
+ *
+ * Coroutine frames bumped from a per-task arena of the _pointer-bumping_ heap.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_COROUTINE_HPP)
+#define _PB_COROUTINE_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <new>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * The arena into which coroutine frames are currently being allocated, or null
+ * to use the global `operator new`.  Each thread runs its own tasks, so each
+ * has its own.
+ */
+inline thread_local pb_arena_s* current_frame_arena = nullptr;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The extent of one task.  While a scope is live, frames of coroutines whose
+ * promise derives from `arena_frames` are bumped from its arena; when it ends,
+ * the arena is rewound to where it was when the scope began, releasing every
+ * frame allocated since, and the enclosing scope, if any, becomes current
+ * again.  No such frame may outlive the scope in which it was made.
+ */
+class frame_scope {
+
+public:
+
+  /** Begin a task whose frames come from `arena`. */
+  explicit frame_scope (pb_arena_s* arena) noexcept
+    : arena_(arena),
+      previous_(current_frame_arena),
+      mark_(pb_arena_mark(arena)) {
+
+    current_frame_arena = arena;
+
+  }
+
+  frame_scope (const frame_scope&)            = delete;
+  frame_scope& operator= (const frame_scope&) = delete;
+
+  ~frame_scope () {
+
+    pb_arena_rewind(arena_, mark_);
+    current_frame_arena = previous_;
+
+  }
+
+private:
+
+  /** The arena of this task, and that of the enclosing one. */
+  pb_arena_s* arena_;
+  pb_arena_s* previous_;
+
+  /** The state of the arena when the task began. */
+  pb_mark_s   mark_;
+
+}; // class frame_scope
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * A mixin for a coroutine's promise type that allocates the coroutine's frame
+ * from the current `frame_scope`.  Allocation is an inline, header-free pointer
+ * bump, and a frame destroyed in LIFO order, as those of nested `co_await`s
+ * are, is handed straight back.  Frames made outside any scope, or once the
+ * arena is full, come from the global `operator new` instead.
+ *
+ * Each frame is followed by a pointer to its arena, so that a frame destroyed
+ * after its scope has moved on still goes back to the right place.
+ */
+struct arena_frames {
+
+  static void* operator new (std::size_t size) {
+
+    std::size_t  total = footprint(size);
+    pb_arena_s*  arena = current_frame_arena;
+    void*        frame = nullptr;
+    if (arena != nullptr) {
+      frame = pb_arena_alloc_raw(arena, total, __STDCPP_DEFAULT_NEW_ALIGNMENT__);
+      if (PB_UNLIKELY(frame == nullptr)) {
+	frame = pb_arena_alloc_raw_slow(arena, total,
+					__STDCPP_DEFAULT_NEW_ALIGNMENT__);
+      }
+    }
+    if (PB_UNLIKELY(frame == nullptr)) {
+      arena = nullptr;
+      frame = ::operator new(total);
+    }
+
+    *owner(frame, size) = arena;
+    return frame;
+
+  }
+
+  static void operator delete (void* frame, std::size_t size) noexcept {
+
+    pb_arena_s* arena = *owner(frame, size);
+    if (arena != nullptr) {
+      pb_arena_free_raw(arena, frame, footprint(size));
+    } else {
+      ::operator delete(frame, footprint(size));
+    }
+
+  }
+
+private:
+
+  /**
+   * \return The bytes taken by a frame of `size` bytes and its owner, rounded
+   *         up to the frame's alignment so that the frame above it is carved
+   *         with no slack, and freeing it restores the cursor exactly.
+   */
+  static constexpr std::size_t footprint (std::size_t size) noexcept {
+    return ((size + sizeof(pb_arena_s*) + __STDCPP_DEFAULT_NEW_ALIGNMENT__ - 1)
+	    & -std::size_t(__STDCPP_DEFAULT_NEW_ALIGNMENT__));
+  }
+
+  /** \return Where the owner of a frame of `size` bytes is kept. */
+  static pb_arena_s** owner (void* frame, std::size_t size) noexcept {
+    return reinterpret_cast<pb_arena_s**>(static_cast<char*>(frame)
+					  + footprint(size)
+					  - sizeof(pb_arena_s*));
+  }
+
+}; // struct arena_frames
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_COROUTINE_HPP
+// ==============================================================================
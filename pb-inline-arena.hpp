@@ -0,0 +1,193 @@
+// ==============================================================================
+/**
+ * pb-inline-arena.hpp
+ *
+ * A bump arena over a buffer of its own, for bounded workloads that should not
+ * touch the _pointer-bumping_ heap at all unless they outgrow it.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_INLINE_ARENA_HPP)
+#define _PB_INLINE_ARENA_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <functional>
+#include <new>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * An arena over an internal buffer of `N` bytes, which lives wherever the
+ * `inline_arena` itself does: on the stack, in static storage, or inside
+ * another object.  Allocation is an inline, header-free bump through the
+ * buffer; once a request does not fit, it is served instead from a fallback
+ * arena (the heap itself, by default).  As with `free()`, a block is reclaimed
+ * only if it was the last one allocated from wherever it came from.
+ *
+ * The arena counts the allocations it serves each way, and the bytes it sends
+ * to the fallback, so that `N` can be sized from what a real workload needs.
+ * Since the arena refers to its own buffer, it can be neither copied nor moved.
+ */
+template <std::size_t N>
+class inline_arena {
+
+  static_assert(N >= 2 * PB_ALIGNMENT, "the buffer must hold at least one block");
+
+public:
+
+  /** The size of the internal buffer. */
+  static constexpr std::size_t capacity = N;
+
+  /**
+   * Make an empty arena.
+   *
+   * \param fallback The arena from which to serve what does not fit; it must
+   *                 outlive this one.
+   */
+  explicit inline_arena (pb_arena_s* fallback = &pb_heap) noexcept
+    : fallback_(fallback),
+      inline_count_(0),
+      fallback_count_(0),
+      fallback_bytes_(0) {
+
+    pb_arena_init_buffer(&arena_, buffer_, N);
+
+  }
+
+  inline_arena (const inline_arena&)            = delete;
+  inline_arena& operator= (const inline_arena&) = delete;
+
+  /**
+   * Allocate `size` bytes aligned to `align`.
+   *
+   * \param size  The number of bytes to allocate.
+   * \param align The required alignment; must be a power of two.
+   * \return      The block.
+   * \throws      `std::bad_alloc` if neither the buffer nor the fallback can
+   *              supply the block.
+   */
+  void* allocate (std::size_t size, std::size_t align = alignof(std::max_align_t)) {
+
+    void* block = pb_arena_alloc_raw(&arena_, pb_raw_footprint(size), align);
+    if (PB_UNLIKELY(block == nullptr)) {
+      return allocate_fallback(size, align);
+    }
+    inline_count_++;
+    return block;
+
+  }
+
+  /**
+   * Hand back a block from `allocate()`.
+   *
+   * \param block The block.
+   * \param size  The size with which the block was allocated.
+   */
+  void deallocate (void* block, std::size_t size) noexcept {
+
+    if (owns(block)) {
+      pb_arena_free_raw(&arena_, block, pb_raw_footprint(size));
+    } else {
+      pb_arena_free_raw(fallback_, block, pb_raw_footprint(size));
+    }
+
+  }
+
+  /**
+   * \return Whether `block` lies in the internal buffer.  A block from the
+   *         fallback is an unrelated object, which the built-in `<` does not
+   *         order, so the comparison is made with `std::less`, which does.
+   */
+  bool owns (const void* block) const noexcept {
+    std::less<const void*> before;
+    return (!before(block, buffer_) && before(block, buffer_ + N));
+  }
+
+  /**
+   * Release everything allocated from the internal buffer.  Blocks from the
+   * fallback are left to it; the counters are kept.
+   */
+  void reset () noexcept {
+    pb_arena_reset(&arena_);
+  }
+
+  /** \return The arena over the internal buffer, and the fallback arena. */
+  pb_arena_s* arena () noexcept {
+    return &arena_;
+  }
+
+  pb_arena_s* fallback () const noexcept {
+    return fallback_;
+  }
+
+  /** \return The number of allocations served from the internal buffer. */
+  std::size_t inline_count () const noexcept {
+    return inline_count_;
+  }
+
+  /** \return The number of allocations, and of bytes, sent to the fallback. */
+  std::size_t fallback_count () const noexcept {
+    return fallback_count_;
+  }
+
+  std::size_t fallback_bytes () const noexcept {
+    return fallback_bytes_;
+  }
+
+private:
+
+  /** Serve a request that does not fit in the internal buffer. */
+  void* allocate_fallback (std::size_t size, std::size_t align) {
+
+    void* block = pb_arena_alloc_raw(fallback_, pb_raw_footprint(size), align);
+    if (block == nullptr) {
+      block = pb_arena_alloc_raw_slow(fallback_, pb_raw_footprint(size), align);
+      if (block == nullptr) {
+	throw std::bad_alloc();
+      }
+    }
+    fallback_count_++;
+    fallback_bytes_ += size;
+    return block;
+
+  }
+
+  /** The buffer, and the arena over it. */
+  alignas(PB_ALIGNMENT) std::byte buffer_[N];
+  pb_arena_s                      arena_;
+
+  /** Where requests that do not fit are sent. */
+  pb_arena_s*                     fallback_;
+
+  /** How the allocations so far have been served. */
+  std::size_t                     inline_count_;
+  std::size_t                     fallback_count_;
+  std::size_t                     fallback_bytes_;
+
+}; // class inline_arena
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_INLINE_ARENA_HPP
+// ==============================================================================
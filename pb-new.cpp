@@ -0,0 +1,217 @@
+// ==============================================================================
+/**
+ * pb-new.cpp
+ *
+ * Replacements for every global `operator new` and `operator delete` that go
+ * straight to the _pointer-bumping_ heap's inline fast paths, rather than
+ * through libstdc++'s wrappers around `malloc()` and `free()`.
+ *
+ * Ordinary blocks are allocated as `malloc()` allocates them, header and all,
+ * so that the unsized `operator delete` can find their size.  Over-aligned
+ * blocks are headerless, as from `pb_alloc_raw()`; they can be reclaimed only
+ * by the sized, aligned `operator delete`, since nothing else knows how big
+ * they are.  Sized deletion of either kind never reads a header at all.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <new>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The out-of-line half of every throwing `operator new`: retry through the
+ * allocator's own slow path, calling the new-handler between attempts until
+ * the request succeeds or there is no handler left to call.
+ *
+ * \param size  The number of bytes to allocate.
+ * \param align The required alignment, or zero for an ordinary block.
+ * \return      A pointer to the allocated block.
+ * \throws      `std::bad_alloc` if the block cannot be allocated.
+ */
+__attribute__((noinline, cold))
+static void* new_slow (std::size_t size, std::size_t align) {
+
+  // Every object must have an address of its own, even if it is empty.
+  if (size == 0) {
+    size = 1;
+  }
+
+  while (true) {
+    void* block = (align == 0
+		   ? pb_malloc_slow(size)
+		   : pb_alloc_raw_slow(size, align));
+    if (block != nullptr) {
+      return block;
+    }
+
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) {
+      throw std::bad_alloc();
+    }
+    handler();
+  }
+
+} // new_slow ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+// ALLOCATION
+
+void* operator new (std::size_t size) {
+
+  void* block = pb_arena_alloc(&pb_heap, size);
+  if (PB_UNLIKELY(block == nullptr)) {
+    return new_slow(size, 0);
+  }
+  return block;
+
+}
+
+void* operator new[] (std::size_t size) {
+
+  return operator new(size);
+
+}
+
+void* operator new (std::size_t size, std::align_val_t align) {
+
+  // A zero-byte raw block would share its address with the next one.
+  std::size_t bytes = size + (size == 0);
+  void*       block = pb_arena_alloc_raw(&pb_heap, bytes, std::size_t(align));
+  if (PB_UNLIKELY(block == nullptr)) {
+    return new_slow(bytes, std::size_t(align));
+  }
+  return block;
+
+}
+
+void* operator new[] (std::size_t size, std::align_val_t align) {
+
+  return operator new(size, align);
+
+}
+
+void* operator new (std::size_t size, const std::nothrow_t&) noexcept {
+
+  try {
+    return operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+
+}
+
+void* operator new[] (std::size_t size, const std::nothrow_t&) noexcept {
+
+  try {
+    return operator new(size);
+  } catch (...) {
+    return nullptr;
+  }
+
+}
+
+void* operator new (std::size_t            size,
+		    std::align_val_t       align,
+		    const std::nothrow_t&) noexcept {
+
+  try {
+    return operator new(size, align);
+  } catch (...) {
+    return nullptr;
+  }
+
+}
+
+void* operator new[] (std::size_t            size,
+		      std::align_val_t       align,
+		      const std::nothrow_t&) noexcept {
+
+  try {
+    return operator new(size, align);
+  } catch (...) {
+    return nullptr;
+  }
+
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+// DEALLOCATION
+//
+// As with `free()`, only the block at the top of the heap is actually
+// reclaimed; the rest are left where they are.
+
+void operator delete (void* ptr) noexcept {
+
+  if (ptr != nullptr) {
+    pb_arena_free(&pb_heap, ptr);
+  }
+
+}
+
+void operator delete[] (void* ptr) noexcept {
+
+  operator delete(ptr);
+
+}
+
+void operator delete (void* ptr, const std::nothrow_t&) noexcept {
+
+  operator delete(ptr);
+
+}
+
+void operator delete[] (void* ptr, const std::nothrow_t&) noexcept {
+
+  operator delete(ptr);
+
+}
+
+void operator delete (void* ptr, std::size_t size) noexcept {
+
+  pb_free_sized(ptr, size);
+
+}
+
+void operator delete[] (void* ptr, std::size_t size) noexcept {
+
+  pb_free_sized(ptr, size);
+
+}
+
+void operator delete (void* ptr, std::size_t size, std::align_val_t) noexcept {
+
+  // Match the size that the block was allocated with.
+  if (ptr != nullptr) {
+    pb_free_raw(ptr, size + (size == 0));
+  }
+
+}
+
+void operator delete[] (void* ptr, std::size_t size, std::align_val_t align) noexcept {
+
+  operator delete(ptr, size, align);
+
+}
+
+// Without its size, a headerless block cannot be reclaimed, so these leave it.
+void operator delete (void*, std::align_val_t) noexcept {}
+void operator delete[] (void*, std::align_val_t) noexcept {}
+void operator delete (void*, std::align_val_t, const std::nothrow_t&) noexcept {}
+void operator delete[] (void*, std::align_val_t, const std::nothrow_t&) noexcept {}
+// ==============================================================================
@@ -0,0 +1,182 @@
+// ==============================================================================
+/**
+ * pb-pool.hpp
+ *
+ * A pool of fixed-size objects carved in chunks from the _pointer-bumping_
+ * heap, which, unlike `free()`, reuses every object handed back to it.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_POOL_HPP)
+#define _PB_POOL_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cstddef>
+#include <new>
+#include <utility>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * A pool of objects of type `T`.  Slots are carved `ChunkObjects` at a time, as
+ * a single headerless block, from an arena (the heap itself, by default), and
+ * handed out from the newest chunk by bumping a cursor through it.  A slot
+ * given back goes onto an intrusive free list threaded through the slots
+ * themselves, and is the next to be handed out; so both allocation and
+ * deallocation are O(1), and no slot carries a header.
+ *
+ * Chunks are never given back; they live as long as the arena does.
+ */
+template <typename T, std::size_t ChunkObjects = 64>
+class object_pool {
+
+  static_assert(ChunkObjects > 0, "a chunk must hold at least one object");
+
+  /** A slot holds an object while in use, and a link while free. */
+  union slot_u {
+    slot_u* next;
+    alignas(T) std::byte object[sizeof(T)];
+  };
+
+public:
+
+  using value_type = T;
+
+  /** The bytes taken by, and the alignment of, each slot. */
+  static constexpr std::size_t slot_size  = sizeof(slot_u);
+  static constexpr std::size_t slot_align = alignof(slot_u);
+
+  /** The objects per chunk, and the bytes carved for each chunk. */
+  static constexpr std::size_t chunk_objects = ChunkObjects;
+  static constexpr std::size_t chunk_size    = ChunkObjects * slot_size;
+
+  /** Carve chunks from the heap itself. */
+  object_pool () noexcept
+    : object_pool(&pb_heap) {}
+
+  /** Carve chunks from `arena`, which must outlive the pool. */
+  explicit object_pool (pb_arena_s* arena) noexcept
+    : arena_(arena),
+      free_(nullptr),
+      next_(nullptr),
+      end_(nullptr) {}
+
+  object_pool (const object_pool&)            = delete;
+  object_pool& operator= (const object_pool&) = delete;
+
+  /** \return The arena from which chunks are carved. */
+  pb_arena_s* arena () const noexcept {
+    return arena_;
+  }
+
+  /**
+   * Take a slot for one `T`, without constructing it.
+   *
+   * \return The slot.
+   * \throws `std::bad_alloc` if a new chunk is needed and cannot be carved.
+   */
+  T* allocate () {
+
+    slot_u* slot = free_;
+    if (slot != nullptr) {
+      free_ = slot->next;
+    } else if (PB_UNLIKELY(next_ == end_)) {
+      slot = refill();
+    } else {
+      slot = next_++;
+    }
+    return reinterpret_cast<T*>(slot);
+
+  }
+
+  /**
+   * Give back a slot from `allocate()`, whose object has been destroyed.
+   *
+   * \param object The slot.
+   */
+  void deallocate (T* object) noexcept {
+
+    slot_u* slot = reinterpret_cast<slot_u*>(object);
+    slot->next   = free_;
+    free_        = slot;
+
+  }
+
+  /** Take a slot and construct a `T` in it from `args`. */
+  template <typename... Args>
+  T* create (Args&&... args) {
+
+    T* object = allocate();
+    try {
+      return ::new (static_cast<void*>(object)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      deallocate(object);
+      throw;
+    }
+
+  }
+
+  /** Destroy an object from `create()` and give back its slot. */
+  void destroy (T* object) noexcept {
+
+    object->~T();
+    deallocate(object);
+
+  }
+
+private:
+
+  /** Carve a new chunk, make it current, and take its first slot. */
+  slot_u* refill () {
+
+    void* chunk = pb_arena_alloc_raw(arena_, chunk_size, slot_align);
+    if (chunk == nullptr) {
+      chunk = pb_arena_alloc_raw_slow(arena_, chunk_size, slot_align);
+      if (chunk == nullptr) {
+	throw std::bad_alloc();
+      }
+    }
+
+    slot_u* first = static_cast<slot_u*>(chunk);
+    next_ = first + 1;
+    end_  = first + ChunkObjects;
+    return first;
+
+  }
+
+  /** The arena from which chunks are carved. */
+  pb_arena_s* arena_;
+
+  /** The most recently freed slot, linked to the next most recent. */
+  slot_u*     free_;
+
+  /** The untouched slots of the newest chunk. */
+  slot_u*     next_;
+  slot_u*     end_;
+
+}; // class object_pool
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_POOL_HPP
+// ==============================================================================
@@ -0,0 +1,130 @@
+// ==============================================================================
+/**
+ * pb-probe.h
+ *
+ * Static probes (USDT, as SystemTap's `<sys/sdt.h>` defines them) in the
+ * _pointer-bumping_ allocator, for `bpftrace`, `perf probe` and the like to
+ * attach to.  Each probe is a single `nop` where it is placed, and a note in
+ * the `.note.stapsdt` section that tells a tracer where that `nop` is and
+ * where to find the probe's arguments; a tracer that attaches replaces the
+ * `nop` with a breakpoint, so a probe costs nothing else while none is.
+ *
+ * `<sys/sdt.h>` is used where it is installed.  Where it is not, the notes are
+ * emitted here in the same format, on x86-64 only, with every argument passed
+ * as an unsigned 64-bit value; elsewhere the probes compile away, as they do
+ * everywhere with `PB_NO_PROBES` defined.  Every probe's provider is `pb`:
+ *
+ *   bpftrace -e 'usdt:./libpb.so:pb:malloc { @[arg0] = count(); }'
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_PROBE_H)
+#define _PB_PROBE_H
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdint.h>
+
+#if !defined (PB_NO_PROBES) && defined (__has_include)
+#if __has_include (<sys/sdt.h>)
+#include <sys/sdt.h>
+#define PB_PROBE_SDT
+#endif
+#endif
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+#if defined (PB_PROBE_SDT)
+
+#define PB_PROBE0(name)                 STAP_PROBE(pb, name)
+#define PB_PROBE1(name, a1)             STAP_PROBE1(pb, name, a1)
+#define PB_PROBE2(name, a1, a2)         STAP_PROBE2(pb, name, a1, a2)
+#define PB_PROBE3(name, a1, a2, a3)     STAP_PROBE3(pb, name, a1, a2, a3)
+#define PB_PROBE4(name, a1, a2, a3, a4) STAP_PROBE4(pb, name, a1, a2, a3, a4)
+
+#elif !defined (PB_NO_PROBES) && defined (__x86_64__) && defined (__GNUC__)
+
+/**
+ * Place a probe: the `nop`; then its note, which gives the `nop`'s address,
+ * that of the `.stapsdt.base` section (from which a tracer works out how far
+ * the object was moved when loaded), no semaphore, the provider, the probe's
+ * name, and where each argument is (e.g., `8@%rdi`); and the section itself,
+ * once per object.
+ */
+#define PB_PROBE_ASM(name, args, ...)					\
+  __asm__ __volatile__ ("990: nop\n"					\
+			".pushsection .note.stapsdt, \"?\", \"note\"\n"	\
+			".balign 4\n"					\
+			".4byte 992f - 991f, 994f - 993f, 3\n"		\
+			"991: .asciz \"stapsdt\"\n"			\
+			"992: .balign 4\n"				\
+			"993: .8byte 990b\n"				\
+			".8byte _.stapsdt.base\n"			\
+			".8byte 0\n"					\
+			".asciz \"pb\"\n"				\
+			".asciz \"" #name "\"\n"			\
+			".asciz \"" args "\"\n"				\
+			"994: .balign 4\n"				\
+			".popsection\n"					\
+			".ifndef _.stapsdt.base\n"			\
+			".pushsection .stapsdt.base, \"aG\", \"progbits\", " \
+			".stapsdt.base, comdat\n"			\
+			".weak _.stapsdt.base\n"			\
+			".hidden _.stapsdt.base\n"			\
+			"_.stapsdt.base: .space 1\n"			\
+			".size _.stapsdt.base, 1\n"			\
+			".popsection\n"					\
+			".endif\n"					\
+			:: __VA_ARGS__)
+
+/** Each argument may be wherever the compiler has it: in a register, in
+ *  memory, or a constant. */
+#define PB_PROBE0(name)							\
+  PB_PROBE_ASM(name, "")
+#define PB_PROBE1(name, v1)						\
+  PB_PROBE_ASM(name, "8@%[a1]", [a1] "nor" ((uint64_t)(uintptr_t)(v1)))
+#define PB_PROBE2(name, v1, v2)						\
+  PB_PROBE_ASM(name, "8@%[a1] 8@%[a2]",					\
+	       [a1] "nor" ((uint64_t)(uintptr_t)(v1)),			\
+	       [a2] "nor" ((uint64_t)(uintptr_t)(v2)))
+#define PB_PROBE3(name, v1, v2, v3)					\
+  PB_PROBE_ASM(name, "8@%[a1] 8@%[a2] 8@%[a3]",				\
+	       [a1] "nor" ((uint64_t)(uintptr_t)(v1)),			\
+	       [a2] "nor" ((uint64_t)(uintptr_t)(v2)),			\
+	       [a3] "nor" ((uint64_t)(uintptr_t)(v3)))
+#define PB_PROBE4(name, v1, v2, v3, v4)					\
+  PB_PROBE_ASM(name, "8@%[a1] 8@%[a2] 8@%[a3] 8@%[a4]",			\
+	       [a1] "nor" ((uint64_t)(uintptr_t)(v1)),			\
+	       [a2] "nor" ((uint64_t)(uintptr_t)(v2)),			\
+	       [a3] "nor" ((uint64_t)(uintptr_t)(v3)),			\
+	       [a4] "nor" ((uint64_t)(uintptr_t)(v4)))
+
+#else
+
+#define PB_PROBE0(name)                 ((void)0)
+#define PB_PROBE1(name, a1)             ((void)0)
+#define PB_PROBE2(name, a1, a2)         ((void)0)
+#define PB_PROBE3(name, a1, a2, a3)     ((void)0)
+#define PB_PROBE4(name, a1, a2, a3, a4) ((void)0)
+
+#endif
+// ==============================================================================
+
+
+
+// ==============================================================================
+#endif // _PB_PROBE_H
+// ==============================================================================
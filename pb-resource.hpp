@@ -0,0 +1,210 @@
+// ==============================================================================
+/**
+ * pb-resource.hpp
+ *
+ * A `std::pmr::memory_resource` that bumps through a dedicated arena of the
+ * _pointer-bumping_ heap, falling back to an upstream resource when it fills.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_RESOURCE_HPP)
+#define _PB_RESOURCE_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <algorithm>
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * A memory resource over its own arena, carved from the pb heap when the
+ * resource is made.  Allocation is a pointer bump; deallocation hands a block
+ * back only if it was the last one allocated, as `free()` does, and otherwise
+ * does nothing.  Once the arena is full, further chunks are taken from the
+ * upstream resource, growing geometrically, and bumped through in turn.
+ * `release()` hands those chunks back upstream and empties the arena.
+ */
+class bump_resource : public std::pmr::memory_resource {
+
+public:
+
+  /**
+   * Make a resource with an arena of `capacity` bytes.
+   *
+   * \param capacity The number of bytes to carve from the pb heap; if zero, or
+   *                 if the heap cannot supply them, every allocation goes
+   *                 upstream.
+   * \param upstream The resource from which to take further chunks.
+   */
+  explicit bump_resource (std::size_t                capacity,
+			  std::pmr::memory_resource* upstream =
+			  std::pmr::get_default_resource())
+    : upstream_(upstream),
+      chunks_(nullptr),
+      next_chunk_size_(std::max(capacity, min_chunk_size)) {
+
+    if (capacity == 0 || !pb_arena_init(&home_, capacity)) {
+      home_ = pb_arena_s();
+    }
+    arena_ = home_;
+
+  }
+
+  bump_resource (const bump_resource&)            = delete;
+  bump_resource& operator= (const bump_resource&) = delete;
+
+  ~bump_resource () override {
+
+    release();
+    if (home_.start_addr != nullptr) {
+      pb_arena_destroy(&home_);
+    }
+
+  }
+
+  /**
+   * Release everything allocated from this resource, handing any upstream
+   * chunks back.
+   */
+  void release () noexcept {
+
+    while (chunks_ != nullptr) {
+      chunk_s* prev = chunks_->prev;
+      upstream_->deallocate(chunks_, chunks_->size, alignof(std::max_align_t));
+      chunks_ = prev;
+    }
+
+    arena_ = home_;
+    if (arena_.start_addr != nullptr) {
+      pb_arena_reset(&arena_);
+    }
+
+  }
+
+  /** \return The resource from which further chunks are taken. */
+  std::pmr::memory_resource* upstream_resource () const noexcept {
+    return upstream_;
+  }
+
+  /** \return The arena currently being bumped through. */
+  pb_arena_s* arena () noexcept {
+    return &arena_;
+  }
+
+protected:
+
+  void* do_allocate (std::size_t bytes, std::size_t alignment) override {
+
+    // Carve whole multiples of PB_ALIGNMENT, so that blocks handed back in LIFO
+    // order restore the cursor exactly.
+    std::size_t size  = pb_raw_footprint(bytes);
+    void*       block = pb_arena_alloc_raw(&arena_, size, alignment);
+    if (PB_UNLIKELY(block == nullptr)) {
+      return allocate_from_upstream(size, alignment);
+    }
+    return block;
+
+  }
+
+  void do_deallocate (void*       block,
+		      std::size_t bytes,
+		      std::size_t alignment) override {
+
+    pb_arena_free_raw(&arena_, block, pb_raw_footprint(bytes));
+
+  }
+
+  bool do_is_equal (const std::pmr::memory_resource& other) const noexcept override {
+
+    return this == &other;
+
+  }
+
+private:
+
+  /** The smallest chunk worth taking from upstream. */
+  static constexpr std::size_t min_chunk_size = 4096;
+
+  /** The bookkeeping at the start of each upstream chunk. */
+  struct chunk_s {
+    chunk_s*    prev;
+    std::size_t size;
+  };
+
+  /**
+   * Take a chunk big enough for the request from upstream, make it the arena,
+   * and allocate from it.
+   *
+   * \param size      The footprint of the block, from `pb_raw_footprint()`.
+   * \param alignment The block's alignment.
+   * \throws          `std::bad_alloc` if the chunk would be too large, or if
+   *                  upstream cannot supply it.
+   */
+  void* allocate_from_upstream (std::size_t size, std::size_t alignment) {
+
+    // Past the bookkeeping, the arena over the chunk starts a header short of
+    // a boundary of PB_ALIGNMENT, and the block may need all but one byte of
+    // its alignment as slack; a second PB_ALIGNMENT covers the first two.
+    constexpr std::size_t overhead = sizeof(chunk_s) + 2 * PB_ALIGNMENT;
+    if (PB_UNLIKELY(size      > PB_MAX_SIZE - overhead ||
+		    alignment > PB_MAX_SIZE - overhead - size)) {
+      throw std::bad_alloc();
+    }
+    std::size_t chunk_size = std::max(next_chunk_size_, overhead + size + alignment);
+    chunk_s*    chunk      = static_cast<chunk_s*>(upstream_->allocate(chunk_size,
+								      alignof(std::max_align_t)));
+    chunk->prev      = chunks_;
+    chunk->size      = chunk_size;
+    chunks_          = chunk;
+    next_chunk_size_ = chunk_size <= PB_MAX_SIZE / 2 ? chunk_size * 2 : chunk_size;
+
+    void* block = nullptr;
+    if (pb_arena_init_buffer(&arena_, chunk + 1, chunk_size - sizeof(chunk_s))) {
+      block = pb_arena_alloc_raw(&arena_, size, alignment);
+    }
+    if (PB_UNLIKELY(block == nullptr)) {
+      throw std::bad_alloc();
+    }
+    return block;
+
+  }
+
+  /** The arena being bumped through: home_, or the newest upstream chunk. */
+  pb_arena_s                 arena_;
+
+  /** The arena carved from the pb heap, or all null if there is none. */
+  pb_arena_s                 home_;
+
+  /** Where further chunks come from, and the newest of them. */
+  std::pmr::memory_resource* upstream_;
+  chunk_s*                   chunks_;
+  std::size_t                next_chunk_size_;
+
+}; // class bump_resource
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_RESOURCE_HPP
+// ==============================================================================
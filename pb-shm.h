@@ -0,0 +1,139 @@
+// ==============================================================================
+/**
+ * pb-shm.h
+ *
+ * The layout of the live statistics page that a `PB_STATS` build of the
+ * _pointer-bumping_ allocator publishes under `/dev/shm`, shared by the
+ * allocator and by `pbstat`, which reads it.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_SHM_H)
+#define _PB_SHM_H
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** The environment variable that, if set to `1`, publishes the page. */
+#define PB_SHM_ENV "PB_SHM_STATS"
+
+/** The page's path is this prefix followed by the process ID. */
+#define PB_SHM_PREFIX "/dev/shm/pb-"
+
+/** Identify the page and the version of its layout. */
+#define PB_SHM_MAGIC   0x31746174736270ULL /* "pbstat1" */
+#define PB_SHM_VERSION 1
+
+/** The number of size classes in the histogram. */
+#define PB_SHM_CLASSES 32
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/**
+ * The live statistics page.  The allocator is its only writer, and updates it
+ * with relaxed stores.  The cursors and the byte counts that must agree with
+ * them are written inside a seqlock: `seq` is odd while an update is under way,
+ * and a reader that sees it change must read again.  The count of `malloc()`
+ * calls and the histogram are bumped in the same update as the byte counts, so
+ * they agree with them too; the counts of the other calls only ever grow, and
+ * are bumped outside it, at the entry points.
+ */
+typedef struct pb_shm_page {
+
+  /** `PB_SHM_MAGIC` and `PB_SHM_VERSION`, and the process that writes it. */
+  uint64_t   magic;
+  uint32_t   version;
+  uint32_t   pid;
+
+  /** The seqlock's sequence number. */
+  uint64_t   seq;
+
+  /** The bounds of the heap, and its cursors as of the last update. */
+  char*      start_addr;
+  char*      limit_addr;
+  char*      free_addr;
+  char*      end_addr;
+
+  /** The counters; the fields read from the cursors are left zero. */
+  pb_stats_s stats;
+
+  /** Allocations by size class; see `pb_shm_class()`. */
+  uint64_t   histogram[PB_SHM_CLASSES];
+
+} pb_shm_page_s;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * The size class of a request: the number of bits needed to write `size - 1`,
+ * so that class `c` holds sizes from `2^(c-1) + 1` to `2^c`, with everything
+ * too large for the last class lumped into it.
+ *
+ * \param size The number of bytes requested.
+ * \return     The request's class.
+ */
+static inline unsigned int pb_shm_class (size_t size) {
+
+  unsigned int bits = size <= 1 ? 0 : 64 - __builtin_clzll(size - 1);
+  return bits < PB_SHM_CLASSES ? bits : PB_SHM_CLASSES - 1;
+
+} // pb_shm_class ()
+
+
+
+/**
+ * Take a consistent copy of a page that another process may be updating.
+ *
+ * \param page The page, mapped read-only.
+ * \param copy Where to put the copy.
+ * \return     `true` if successful; `false` if the writer was mid-update
+ *             every time the page was tried.
+ */
+static inline bool pb_shm_read (const pb_shm_page_s* page, pb_shm_page_s* copy) {
+
+  for (int attempt = 0; attempt < 1000; attempt++) {
+    uint64_t seq = __atomic_load_n(&page->seq, __ATOMIC_ACQUIRE);
+    if (seq & 1) {
+      continue;
+    }
+    __builtin_memcpy(copy, (const void*)page, sizeof(*copy));
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if (__atomic_load_n(&page->seq, __ATOMIC_RELAXED) == seq) {
+      return true;
+    }
+  }
+  return false;
+
+} // pb_shm_read ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+#endif // _PB_SHM_H
+// ==============================================================================
@@ -0,0 +1,202 @@
+// ==============================================================================
+/**
+ * pb-soa.hpp
+ *
+ * Struct-of-arrays blocks: several columns of elements, each aligned for SIMD,
+ * allocated together with a single bump of the _pointer-bumping_ heap.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_SOA_HPP)
+#define _PB_SOA_HPP
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+namespace pb {
+
+// ==============================================================================
+/**
+ * One headerless block holding `rows` elements of each of `Ts...`, column by
+ * column.  Each column starts on a boundary of `Align`, or of its element's
+ * own alignment if that is larger.  The layout for a given row count is a
+ * `constexpr` function of the types, so it can be worked out at compile time.
+ *
+ * The elements must be trivial types, and are left uninitialized, as by
+ * `malloc()`.  The block is handed back when destroyed, if it is still the
+ * last one allocated from its arena.
+ */
+template <std::size_t Align, typename... Ts>
+class basic_soa_block {
+
+  static_assert(sizeof...(Ts) > 0, "a block needs at least one column");
+  static_assert(Align != 0 && (Align & (Align - 1)) == 0,
+		"the column alignment must be a power of two");
+  static_assert((std::is_trivially_copyable_v<Ts> && ...) &&
+		(std::is_trivially_destructible_v<Ts> && ...),
+		"columns hold only trivial types");
+
+public:
+
+  /** The number of columns. */
+  static constexpr std::size_t columns = sizeof...(Ts);
+
+  /** The size of each column's elements. */
+  static constexpr std::array<std::size_t, columns> sizes = { sizeof(Ts)... };
+
+  /** The alignment of each column's start. */
+  static constexpr std::array<std::size_t, columns> alignments = {
+    std::max(Align, alignof(Ts))...
+  };
+
+  /** The alignment of the block: that of its most demanding column. */
+  static constexpr std::size_t alignment =
+    *std::max_element(alignments.begin(), alignments.end());
+
+  /** The most rows that a block can hold without its size overflowing. */
+  static constexpr std::size_t max_rows =
+    (PB_MAX_SIZE / 2) / (sizeof(Ts) + ...);
+
+  /** Where each column begins, and the size of the whole block. */
+  struct layout_s {
+    std::array<std::size_t, columns> offsets;
+    std::size_t                      size;
+  };
+
+  /**
+   * Lay out a block of `rows` rows, which must not exceed `max_rows`.
+   *
+   * \param rows The number of elements in each column.
+   * \return     The offset of each column, and the size of the block.
+   */
+  static constexpr layout_s layout (std::size_t rows) noexcept {
+
+    layout_s    result = {};
+    std::size_t total  = 0;
+    for (std::size_t i = 0; i < columns; i++) {
+      total              = (total + alignments[i] - 1) & -alignments[i];
+      result.offsets[i]  = total;
+      total             += sizes[i] * rows;
+    }
+    result.size = total;
+    return result;
+
+  }
+
+  /**
+   * Allocate a block of `rows` rows from `arena`.
+   *
+   * \param rows  The number of elements in each column.
+   * \param arena The arena to allocate from; the heap itself, by default.
+   * \throws      `std::bad_array_new_length` if `rows` exceeds `max_rows`, or
+   *              `std::bad_alloc` if the block cannot be allocated.
+   */
+  explicit basic_soa_block (std::size_t rows, pb_arena_s* arena = &pb_heap)
+    : arena_(arena),
+      rows_(rows) {
+
+    if (PB_UNLIKELY(rows > max_rows)) {
+      throw std::bad_array_new_length();
+    }
+
+    layout_s shape = layout(rows);
+    size_ = shape.size;
+
+    // Never ask for zero bytes, which a raw bump may refuse.
+    std::size_t bytes = size_ + (size_ == 0);
+    block_ = static_cast<std::byte*>(pb_arena_alloc_raw(arena_, bytes, alignment));
+    if (PB_UNLIKELY(block_ == nullptr)) {
+      block_ = static_cast<std::byte*>(pb_arena_alloc_raw_slow(arena_, bytes,
+							       alignment));
+      if (block_ == nullptr) {
+	throw std::bad_alloc();
+      }
+    }
+    size_ = bytes;
+
+    for (std::size_t i = 0; i < columns; i++) {
+      bases_[i] = block_ + shape.offsets[i];
+    }
+
+  }
+
+  basic_soa_block (const basic_soa_block&)            = delete;
+  basic_soa_block& operator= (const basic_soa_block&) = delete;
+
+  ~basic_soa_block () {
+
+    pb_arena_free_raw(arena_, block_, size_);
+
+  }
+
+  /** \return The first element of column `I`. */
+  template <std::size_t I>
+  auto* column () noexcept {
+
+    using element = std::tuple_element_t<I, std::tuple<Ts...>>;
+    return std::assume_aligned<alignments[I]>(reinterpret_cast<element*>(bases_[I]));
+
+  }
+
+  /** \return The number of elements in each column. */
+  std::size_t rows () const noexcept {
+    return rows_;
+  }
+
+  /** \return The whole block, and its size. */
+  void* data () noexcept {
+    return block_;
+  }
+
+  std::size_t size () const noexcept {
+    return size_;
+  }
+
+private:
+
+  /** The arena the block came from, and the block itself. */
+  pb_arena_s*                     arena_;
+  std::byte*                      block_;
+  std::size_t                     size_;
+
+  /** The number of rows, and where each column begins. */
+  std::size_t                     rows_;
+  std::array<std::byte*, columns> bases_;
+
+}; // class basic_soa_block
+
+
+
+/** A struct-of-arrays block whose columns are aligned to cache lines. */
+template <typename... Ts>
+using soa_block = basic_soa_block<64, Ts...>;
+// ==============================================================================
+
+} // namespace pb
+
+
+
+// ==============================================================================
+#endif // _PB_SOA_HPP
+// ==============================================================================
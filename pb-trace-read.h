@@ -0,0 +1,431 @@
+// ==============================================================================
+/**
+ * pb-trace-read.h
+ *
+ * Reading allocation traces (see `pb-trace.h`) in the tools that replay and
+ * simulate them: mapping a trace file, and naming its blocks by slots rather
+ * than by the addresses they had when traced.  Everything here is mapped
+ * directly rather than allocated, so that it never disturbs an allocator
+ * under study.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// Avoid multiple inclusion.
+
+#if !defined (_PB_TRACE_READ_H)
+#define _PB_TRACE_READ_H
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "pb-trace.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// MACRO CONSTANTS AND FUNCTIONS
+
+/** No slot, for an event that takes no block or keeps none. */
+#define PB_TRACE_NO_SLOT UINT32_MAX
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** A mapped trace file. */
+typedef struct pb_trace_file {
+
+  /** The whole file, and its length. */
+  const uint8_t*           data;
+  size_t                   length;
+
+  /** The header, and the encoded events that follow it. */
+  const pb_trace_header_s* header;
+  const uint8_t*           begin;
+  const uint8_t*           end;
+
+  /** For a spool, the events encoded from it, and the size of their mapping;
+   *  otherwise `NULL`. */
+  uint8_t*                 encoded;
+  size_t                   encoded_size;
+
+} pb_trace_file_s;
+
+/** An entry of the table from a traced address to its slot. */
+typedef struct pb_trace_entry {
+
+  uint64_t addr;
+  uint32_t slot;
+
+} pb_trace_entry_s;
+
+/**
+ * Slots for a trace's blocks.  A block takes a slot when it is allocated and
+ * gives it back when it is freed, so the number of slots ever handed out is
+ * the most blocks that were live at once.  Addresses are mapped to slots by
+ * open addressing with linear probing, and entries are deleted by shifting
+ * later ones back, so the table needs no tombstones; address zero marks an
+ * empty entry.  The table doubles once half full.
+ */
+typedef struct pb_trace_slots {
+
+  /** The table, its size less one, and the entries in it. */
+  pb_trace_entry_s* table;
+  size_t            mask;
+  size_t            used;
+
+  /** The slots given back, and room for how many. */
+  uint32_t*         spare;
+  size_t            spare_count;
+  size_t            spare_capacity;
+
+  /** The slots handed out so far. */
+  uint32_t          count;
+
+} pb_trace_slots_s;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Map zeroed memory for a table, or move a table into a larger mapping.
+ *
+ * \param old      The table to move, or `NULL` for a new one.
+ * \param old_size Its size in bytes.
+ * \param size     The size wanted, in bytes.
+ * \return         The table, if successful; `NULL` if not.
+ */
+static inline void* pb_trace_map_table (void* old, size_t old_size, size_t size) {
+
+  void* table = mmap(NULL, size ? size : 1, PROT_READ | PROT_WRITE,
+		     MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (table == MAP_FAILED) {
+    return NULL;
+  }
+  if (old != NULL) {
+    memcpy(table, old, old_size);
+    munmap(old, old_size);
+  }
+  return table;
+
+} // pb_trace_map_table ()
+
+
+
+/**
+ * Encode the records of a mapped spool, as the traced process would have as
+ * it exited, and point `trace` at the encoded events.
+ *
+ * \param trace The trace, whose header is that of a spool.
+ * \return      `true` if successful; `false` if the events cannot be mapped.
+ */
+static inline bool pb_trace_encode_spool (pb_trace_file_s* trace) {
+
+  const pb_trace_record_s* records = (const pb_trace_record_s*)trace->data;
+  size_t                   count   = trace->length / sizeof(pb_trace_record_s);
+  trace->encoded_size = count * PB_TRACE_MAX_EVENT_SIZE;
+  trace->encoded      = pb_trace_map_table(NULL, 0, trace->encoded_size);
+  if (trace->encoded == NULL) {
+    return false;
+  }
+
+  pb_trace_event_s prev  = { 0 };
+  pb_trace_event_s event = { 0 };
+  uint8_t*         out   = trace->encoded;
+  size_t           next  = 1;
+  while (pb_trace_unspool(records, count, &next, &event)) {
+    out = pb_trace_encode(out, &prev, &event);
+  }
+  trace->begin = trace->encoded;
+  trace->end   = out;
+  return true;
+
+} // pb_trace_encode_spool ()
+
+
+
+/**
+ * Map a trace file and check its header.  A spool, left by a process that
+ * never finished tracing, is encoded here.
+ *
+ * \param path  The file.
+ * \param trace Where to describe the mapped trace.
+ * \return      `true` if successful; `false` if not, with a message printed.
+ */
+static inline bool pb_trace_open (const char* path, pb_trace_file_s* trace) {
+
+  int         fd = open(path, O_RDONLY);
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0) {
+    fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+    return false;
+  }
+  if ((size_t)info.st_size < sizeof(pb_trace_header_s)) {
+    fprintf(stderr, "%s is too short to be a trace\n", path);
+    close(fd);
+    return false;
+  }
+  void* data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    fprintf(stderr, "cannot map %s: %s\n", path, strerror(errno));
+    return false;
+  }
+  madvise(data, info.st_size, MADV_SEQUENTIAL);
+
+  trace->data   = data;
+  trace->length = info.st_size;
+  trace->header = data;
+  trace->begin  = trace->data + sizeof(pb_trace_header_s);
+  trace->end    = trace->data + trace->length;
+  trace->encoded      = NULL;
+  trace->encoded_size = 0;
+  if ((trace->header->magic != PB_TRACE_MAGIC &&
+       trace->header->magic != PB_TRACE_SPOOL_MAGIC) ||
+      trace->header->version != PB_TRACE_VERSION) {
+    fprintf(stderr, "%s is not a version %d trace\n", path, PB_TRACE_VERSION);
+    munmap(data, info.st_size);
+    return false;
+  }
+  if (trace->header->magic == PB_TRACE_SPOOL_MAGIC &&
+      !pb_trace_encode_spool(trace)) {
+    fprintf(stderr, "cannot encode the spool %s\n", path);
+    munmap(data, info.st_size);
+    return false;
+  }
+  return true;
+
+} // pb_trace_open ()
+
+
+
+/** Unmap a trace file, and any events encoded from it. */
+static inline void pb_trace_close (pb_trace_file_s* trace) {
+  munmap((void*)trace->data, trace->length);
+  if (trace->encoded != NULL) {
+    munmap(trace->encoded, trace->encoded_size);
+  }
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Prepare slots for a trace's blocks.
+ *
+ * \param slots The slots.
+ * \return      `true` if successful; `false` if the tables cannot be mapped.
+ */
+static inline bool pb_trace_slots_init (pb_trace_slots_s* slots) {
+
+  memset(slots, 0, sizeof(*slots));
+  slots->mask           = 1023;
+  slots->spare_capacity = 1024;
+  slots->table = pb_trace_map_table(NULL, 0, (slots->mask + 1) * sizeof(pb_trace_entry_s));
+  slots->spare = pb_trace_map_table(NULL, 0, slots->spare_capacity * sizeof(uint32_t));
+  return slots->table != NULL && slots->spare != NULL;
+
+} // pb_trace_slots_init ()
+
+
+
+/** Unmap the slots' tables. */
+static inline void pb_trace_slots_destroy (pb_trace_slots_s* slots) {
+
+  munmap(slots->table, (slots->mask + 1) * sizeof(pb_trace_entry_s));
+  munmap(slots->spare, slots->spare_capacity * sizeof(uint32_t));
+  memset(slots, 0, sizeof(*slots));
+
+}
+
+
+
+/** The entry at which the search for `addr` begins. */
+static inline size_t pb_trace_slots_home (const pb_trace_slots_s* slots,
+					  uint64_t                addr) {
+  return (size_t)((addr >> 4) * 0x9e3779b97f4a7c15ULL) & slots->mask;
+}
+
+
+
+/** \return The slot of live block `addr`, or `PB_TRACE_NO_SLOT` if none. */
+static inline uint32_t pb_trace_slots_find (const pb_trace_slots_s* slots,
+					    uint64_t                addr) {
+
+  for (size_t i = pb_trace_slots_home(slots, addr);
+       slots->table[i].addr != 0;
+       i = (i + 1) & slots->mask) {
+    if (slots->table[i].addr == addr) {
+      return slots->table[i].slot;
+    }
+  }
+  return PB_TRACE_NO_SLOT;
+
+} // pb_trace_slots_find ()
+
+
+
+/**
+ * Enter `addr` with `slot`, replacing any entry for it, and growing the table
+ * if it is half full.
+ *
+ * \return `true` if successful; `false` if the table cannot grow.
+ */
+static inline bool pb_trace_slots_bind (pb_trace_slots_s* slots,
+					uint64_t          addr,
+					uint32_t          slot) {
+
+  if (2 * (slots->used + 1) > slots->mask + 1) {
+    pb_trace_slots_s  grown   = *slots;
+    size_t            entries = slots->mask + 1;
+    grown.mask  = 2 * entries - 1;
+    grown.used  = 0;
+    grown.table = pb_trace_map_table(NULL, 0, 2 * entries * sizeof(pb_trace_entry_s));
+    if (grown.table == NULL) {
+      return false;
+    }
+    for (size_t i = 0; i < entries; i++) {
+      if (slots->table[i].addr != 0) {
+	pb_trace_slots_bind(&grown, slots->table[i].addr, slots->table[i].slot);
+      }
+    }
+    munmap(slots->table, entries * sizeof(pb_trace_entry_s));
+    *slots = grown;
+  }
+
+  size_t i = pb_trace_slots_home(slots, addr);
+  while (slots->table[i].addr != 0 && slots->table[i].addr != addr) {
+    i = (i + 1) & slots->mask;
+  }
+  slots->used += slots->table[i].addr == 0;
+  slots->table[i].addr = addr;
+  slots->table[i].slot = slot;
+  return true;
+
+} // pb_trace_slots_bind ()
+
+
+
+/** Remove `addr`, if it is there. */
+static inline void pb_trace_slots_unbind (pb_trace_slots_s* slots, uint64_t addr) {
+
+  size_t i = pb_trace_slots_home(slots, addr);
+  while (slots->table[i].addr != addr) {
+    if (slots->table[i].addr == 0) {
+      return;
+    }
+    i = (i + 1) & slots->mask;
+  }
+
+  // Shift back each later entry of the run that may no longer be reachable.
+  for (size_t j = (i + 1) & slots->mask;
+       slots->table[j].addr != 0;
+       j = (j + 1) & slots->mask) {
+    size_t home = pb_trace_slots_home(slots, slots->table[j].addr);
+    if (((j - home) & slots->mask) >= ((j - i) & slots->mask)) {
+      slots->table[i] = slots->table[j];
+      i = j;
+    }
+  }
+  slots->table[i].addr = 0;
+  slots->used--;
+
+} // pb_trace_slots_unbind ()
+
+
+
+/**
+ * Work out the slots of an event: that of the block passed in, if any, which
+ * is then given back unless the block stays where it is; and that of the block
+ * returned, if any, which is taken.
+ *
+ * A block that the trace never returned was allocated before tracing began;
+ * an event that passes one in is skipped, as is a failed `realloc()`, which
+ * leaves its block as it was.  A failed allocation keeps no slot.
+ *
+ * \param slots The slots.
+ * \param event The event, which must not be a clock event.
+ * \param in    Where to put the slot passed in, or `PB_TRACE_NO_SLOT`.
+ * \param out   Where to put the slot returned, or `PB_TRACE_NO_SLOT`.
+ * \return      `true` if the event should be replayed; `false` if it should be
+ *              skipped, or if a table cannot grow.
+ */
+static inline bool pb_trace_slots_resolve (pb_trace_slots_s*       slots,
+					   const pb_trace_event_s* event,
+					   uint32_t*               in,
+					   uint32_t*               out) {
+
+  *in  = PB_TRACE_NO_SLOT;
+  *out = PB_TRACE_NO_SLOT;
+
+  uint64_t passed = event->op == PB_TRACE_FREE ? event->addr : event->old;
+  if (event->op == PB_TRACE_FREE || (event->op == PB_TRACE_REALLOC && passed != 0)) {
+    *in = pb_trace_slots_find(slots, passed);
+    if (*in == PB_TRACE_NO_SLOT) {
+      return false;
+    }
+  }
+  if (event->op == PB_TRACE_REALLOC && event->addr == 0 && event->size != 0) {
+    *in = PB_TRACE_NO_SLOT;
+    return false;
+  }
+
+  if (*in != PB_TRACE_NO_SLOT) {
+    pb_trace_slots_unbind(slots, passed);
+  }
+  if (event->op != PB_TRACE_FREE && event->addr != 0) {
+    if (*in != PB_TRACE_NO_SLOT) {
+      *out = *in;
+    } else if (slots->spare_count > 0) {
+      *out = slots->spare[--slots->spare_count];
+    } else {
+      *out = slots->count++;
+    }
+    if (!pb_trace_slots_bind(slots, event->addr, *out)) {
+      return false;
+    }
+  }
+
+  if (*in != PB_TRACE_NO_SLOT && *in != *out) {
+    if (slots->spare_count == slots->spare_capacity) {
+      size_t    size  = slots->spare_capacity * sizeof(uint32_t);
+      uint32_t* spare = pb_trace_map_table(slots->spare, size, 2 * size);
+      if (spare == NULL) {
+	return false;
+      }
+      slots->spare           = spare;
+      slots->spare_capacity *= 2;
+    }
+    slots->spare[slots->spare_count++] = *in;
+  }
+  return true;
+
+} // pb_trace_slots_resolve ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+#endif // _PB_TRACE_READ_H
+// ==============================================================================
@@ -0,0 +1,557 @@
+// ==============================================================================
+/**
+ * pbreplay.c
+ *
+ * Replay an allocation trace, as recorded by a `PB_TRACE` build (see
+ * `pb-trace.h`), against each of several allocators, and compare them.
+ *
+ *   pbreplay <trace> [allocator ...]
+ *
+ * An allocator is `glibc`, for the C library's own `malloc()`, or the path of
+ * a shared object that defines `malloc()`, `free()`, `calloc()` and
+ * `realloc()`, which is loaded with `RTLD_DEEPBIND` so that its calls to its
+ * own entry points stay within it.  Without any, `glibc`, `./libpb.so`,
+ * `./libbf.so` and `./libsf.so` are tried in turn.
+ *
+ * The trace is decoded once, before any allocator is loaded, into tables that
+ * are mapped directly rather than allocated: one entry per operation, with
+ * each block named by a slot rather than its original address.  Each
+ * allocator is then run in a child process of its own, twice: once untimed
+ * for throughput, peak RSS and page faults, and once with every operation
+ * timed for the latency percentiles.  A trace from several threads is replayed
+ * by as many threads, which take turns in the trace's order, so that the
+ * original interleaving is kept exactly.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#define _GNU_SOURCE
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "pb-trace-read.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** No slot, for an operation that takes no block or keeps none. */
+#define NO_SLOT PB_TRACE_NO_SLOT
+
+/** The most threads a trace may hold. */
+#define MAX_THREADS 256
+
+/** The page size assumed when touching new blocks. */
+#define TOUCH_STRIDE 4096
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** One operation to replay. */
+typedef struct op {
+
+  /** The operation, as a `pb_trace_op_e`, and the replaying thread. */
+  uint8_t  op;
+  uint8_t  thread;
+
+  /** The slot of the block passed in, and of the block returned. */
+  uint32_t in;
+  uint32_t out;
+
+  /** The bytes requested. */
+  uint64_t size;
+
+  /** The thread's next operation, if any. */
+  uint32_t next;
+
+} op_s;
+
+/** The entry points of an allocator under test. */
+typedef struct allocator {
+
+  const char* name;
+  void* (*malloc)  (size_t);
+  void  (*free)    (void*);
+  void* (*calloc)  (size_t, size_t);
+  void* (*realloc) (void*, size_t);
+
+} allocator_s;
+
+/** What a child process reports back. */
+typedef struct result {
+
+  char     error[128];
+
+  /** From the untimed run. */
+  uint64_t nanos;
+  long     maxrss_kb;
+  long     base_rss_kb;
+  long     minflt;
+  long     majflt;
+
+  /** From the timed run. */
+  uint64_t histogram[BENCH_BUCKETS];
+  uint64_t max_cycles;
+
+} result_s;
+
+extern void* __libc_malloc (size_t size);
+extern void  __libc_free (void* ptr);
+extern void* __libc_calloc (size_t nmemb, size_t size);
+extern void* __libc_realloc (void* ptr, size_t size);
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/** The operations, and how many there are. */
+static op_s*          ops       = NULL;
+static size_t         op_count  = 0;
+
+/** The blocks that the replay holds, by slot. */
+static void**         slots     = NULL;
+static uint32_t       slot_count = 0;
+
+/** Each thread's first operation, and the number of threads. */
+static uint32_t       first_op[MAX_THREADS];
+static int            thread_count = 0;
+
+/** The operations passed over for naming a block the trace never returned. */
+static size_t         skipped   = 0;
+
+/** The allocator under test, and where the child reports. */
+static allocator_s    current;
+static result_s*      result    = NULL;
+
+/** Whether to time each operation, and the cost of timing nothing. */
+static bool           timed     = false;
+static uint64_t       overhead  = 0;
+
+/** The next operation to replay, by whichever thread owns it. */
+static uint32_t       turn      = 0;
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Map anonymous memory for a table, failing outright if it cannot be had.
+ *
+ * \param size The number of bytes.
+ * \return     The zeroed memory.
+ */
+static void* map_table (size_t size) {
+
+  void* table = pb_trace_map_table(NULL, 0, size);
+  if (table == NULL) {
+    fprintf(stderr, "pbreplay: cannot map %zu bytes: %s\n", size, strerror(errno));
+    exit(1);
+  }
+  return table;
+
+} // map_table ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Read a trace and build the operations to replay.  Blocks are given slots as
+ * they are allocated, and slots are reused once their blocks are freed, so
+ * that the replay holds no more slots than the trace had blocks live at once.
+ *
+ * \param path The trace file.
+ */
+static void load_trace (const char* path) {
+
+  pb_trace_file_s trace;
+  if (!pb_trace_open(path, &trace)) {
+    exit(1);
+  }
+
+  // Count the operations, to size the table of them.
+  pb_trace_event_s prev   = { 0 };
+  pb_trace_event_s event;
+  const uint8_t*   in     = trace.begin;
+  size_t           events = 0;
+  while (pb_trace_decode(&in, trace.end, &prev, &event)) {
+    events += event.op != PB_TRACE_CLOCK;
+  }
+
+  pb_trace_slots_s names;
+  uint32_t         tids[MAX_THREADS];
+  uint32_t         last_op[MAX_THREADS];
+  ops = map_table(events * sizeof(op_s));
+  if (!pb_trace_slots_init(&names)) {
+    fprintf(stderr, "pbreplay: cannot map the slot tables\n");
+    exit(1);
+  }
+
+  memset(&prev, 0, sizeof(prev));
+  in = trace.begin;
+  while (pb_trace_decode(&in, trace.end, &prev, &event)) {
+    if (event.op == PB_TRACE_CLOCK) {
+      continue;
+    }
+
+    // Find the thread, adding it if it is new.
+    int thread = 0;
+    while (thread < thread_count && tids[thread] != event.tid) {
+      thread++;
+    }
+    if (thread == thread_count) {
+      if (thread_count == MAX_THREADS) {
+	fprintf(stderr, "pbreplay: more than %d threads in the trace\n", MAX_THREADS);
+	exit(1);
+      }
+      tids[thread_count++] = event.tid;
+      first_op[thread]     = NO_SLOT;
+    }
+
+    op_s op = { .op = event.op, .thread = thread, .size = event.size,
+		.next = NO_SLOT };
+    if (!pb_trace_slots_resolve(&names, &event, &op.in, &op.out)) {
+      skipped++;
+      continue;
+    }
+
+    // Chain the operation onto its thread's.
+    if (first_op[thread] == NO_SLOT) {
+      first_op[thread] = op_count;
+    } else {
+      ops[last_op[thread]].next = op_count;
+    }
+    last_op[thread] = op_count;
+    ops[op_count++] = op;
+  }
+
+  slot_count = names.count;
+  slots      = map_table(slot_count * sizeof(void*));
+  pb_trace_slots_destroy(&names);
+  pb_trace_close(&trace);
+
+} // load_trace ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Write to each page of a new block, as a program would, so that the page
+ * faults and the resident set reflect how the allocator lays blocks out.
+ */
+static inline void touch (char* block, size_t size) {
+
+  if (block == NULL || size == 0) {
+    return;
+  }
+  for (size_t offset = 0; offset < size; offset += TOUCH_STRIDE) {
+    block[offset] = 1;
+  }
+  block[size - 1] = 1;
+
+} // touch ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Replay one operation.
+ */
+static inline void replay_op (const op_s* op) {
+
+  uint64_t start = timed ? bench_cycles() : 0;
+  void*    block;
+  switch (op->op) {
+
+  case PB_TRACE_MALLOC:
+    block = current.malloc(op->size);
+    break;
+
+  case PB_TRACE_CALLOC:
+    block = current.calloc(1, op->size);
+    break;
+
+  case PB_TRACE_REALLOC:
+    block = current.realloc(op->in == NO_SLOT ? NULL : slots[op->in], op->size);
+    break;
+
+  default:
+    current.free(slots[op->in]);
+    block = NULL;
+    break;
+
+  }
+  if (timed) {
+    uint64_t cycles = bench_cycles() - start;
+    cycles = cycles > overhead ? cycles - overhead : 0;
+    result->histogram[bench_bucket(cycles)]++;
+    if (cycles > result->max_cycles) {
+      result->max_cycles = cycles;
+    }
+  }
+
+  if (op->out != NO_SLOT) {
+    slots[op->out] = block;
+    if (op->op != PB_TRACE_CALLOC) {
+      touch(block, op->size);
+    }
+  }
+
+} // replay_op ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Replay one thread's operations, each when its turn comes.
+ *
+ * \param arg The thread's index, as a pointer.
+ * \return    `NULL`.
+ */
+static void* replay_thread (void* arg) {
+
+  int thread = (int)(intptr_t)arg;
+  for (uint32_t i = first_op[thread]; i != NO_SLOT; i = ops[i].next) {
+    while (__atomic_load_n(&turn, __ATOMIC_ACQUIRE) != i) {
+#if defined (__x86_64__) || defined (__i386__)
+      _mm_pause();
+#endif
+    }
+    replay_op(&ops[i]);
+    __atomic_store_n(&turn, i + 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
+
+} // replay_thread ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Replay the whole trace, on one thread if the trace has one, or on as many
+ * threads as it has.
+ */
+static void replay () {
+
+  if (thread_count <= 1) {
+    for (size_t i = 0; i < op_count; i++) {
+      replay_op(&ops[i]);
+    }
+    return;
+  }
+
+  pthread_t threads[MAX_THREADS];
+  for (int thread = 1; thread < thread_count; thread++) {
+    if (pthread_create(&threads[thread], NULL, replay_thread,
+		       (void*)(intptr_t)thread) != 0) {
+      fprintf(stderr, "pbreplay: cannot create a thread\n");
+      exit(1);
+    }
+  }
+  replay_thread((void*)0);
+  for (int thread = 1; thread < thread_count; thread++) {
+    pthread_join(threads[thread], NULL);
+  }
+
+} // replay ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Find an allocator's entry points, loading it if it is a shared object.
+ *
+ * \param name `glibc`, or the path of a shared object.
+ * \return     `true` if successful; `false` if not, with the reason recorded.
+ */
+static bool load_allocator (const char* name) {
+
+  current.name = name;
+  if (strcmp(name, "glibc") == 0) {
+    current.malloc  = __libc_malloc;
+    current.free    = __libc_free;
+    current.calloc  = __libc_calloc;
+    current.realloc = __libc_realloc;
+    return true;
+  }
+
+  void* library = dlopen(name, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+  if (library == NULL) {
+    snprintf(result->error, sizeof(result->error), "%s", dlerror());
+    return false;
+  }
+  current.malloc  = (void* (*) (size_t))dlsym(library, "malloc");
+  current.free    = (void (*) (void*))dlsym(library, "free");
+  current.calloc  = (void* (*) (size_t, size_t))dlsym(library, "calloc");
+  current.realloc = (void* (*) (void*, size_t))dlsym(library, "realloc");
+  if (current.malloc == NULL || current.free == NULL ||
+      current.calloc == NULL || current.realloc == NULL) {
+    snprintf(result->error, sizeof(result->error),
+	     "does not define malloc, free, calloc and realloc");
+    return false;
+  }
+  return true;
+
+} // load_allocator ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * \return The resident set of this process, in kilobytes.
+ */
+static long current_rss_kb () {
+
+  long pages = 0;
+  int  fd    = open("/proc/self/statm", O_RDONLY);
+  char text[128];
+  if (fd >= 0) {
+    ssize_t length = read(fd, text, sizeof(text) - 1);
+    if (length > 0) {
+      text[length] = '\0';
+      sscanf(text, "%*s %ld", &pages);
+    }
+    close(fd);
+  }
+  return pages * (sysconf(_SC_PAGESIZE) / 1024);
+
+} // current_rss_kb ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Run a replay in a child process, which reports into the shared result.
+ *
+ * \param name        The allocator.
+ * \param with_timing Whether to time each operation.
+ * \return      `true` if the child finished; `false` if not.
+ */
+static bool run_child (const char* name, bool with_timing) {
+
+  pid_t child = fork();
+  if (child < 0) {
+    snprintf(result->error, sizeof(result->error), "fork: %s", strerror(errno));
+    return false;
+  }
+
+  if (child == 0) {
+    if (!load_allocator(name)) {
+      _exit(1);
+    }
+    timed = with_timing;
+    if (timed) {
+      overhead = bench_overhead();
+    }
+
+    struct rusage before, after;
+    result->base_rss_kb = current_rss_kb();
+    getrusage(RUSAGE_SELF, &before);
+    uint64_t start = bench_nanos();
+    replay();
+    uint64_t end = bench_nanos();
+    getrusage(RUSAGE_SELF, &after);
+
+    if (!timed) {
+      result->nanos     = end - start;
+      result->maxrss_kb = after.ru_maxrss;
+      result->minflt    = after.ru_minflt - before.ru_minflt;
+      result->majflt    = after.ru_majflt - before.ru_majflt;
+    }
+    _exit(0);
+  }
+
+  int status;
+  while (waitpid(child, &status, 0) < 0 && errno == EINTR) {
+  }
+  if (WIFSIGNALED(status)) {
+    snprintf(result->error, sizeof(result->error), "died of signal %d",
+	     WTERMSIG(status));
+    return false;
+  }
+  return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+} // run_child ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <trace> [glibc | allocator.so ...]\n", argv[0]);
+    return 2;
+  }
+  static const char* defaults[] = { "glibc", "./libpb.so", "./libbf.so", "./libsf.so" };
+  const char** names = argc > 2 ? (const char**)argv + 2 : defaults;
+  int          count = argc > 2 ? argc - 2 : sizeof(defaults) / sizeof(defaults[0]);
+
+  load_trace(argv[1]);
+  printf("%zu operations on %d thread%s, %u blocks live at most",
+	 op_count, thread_count, thread_count == 1 ? "" : "s", slot_count);
+  if (skipped != 0) {
+    printf(", %zu skipped", skipped);
+  }
+  printf("\n%-16s %10s %8s %8s %8s %8s %10s %10s %10s %8s\n", "allocator",
+	 "Mops/s", "p50", "p90", "p99", "p99.9", "max", "maxrss KB",
+	 "base KB", "minflt");
+
+  result = mmap(NULL, sizeof(result_s), PROT_READ | PROT_WRITE,
+		MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (result == MAP_FAILED) {
+    fprintf(stderr, "pbreplay: cannot map the results: %s\n", strerror(errno));
+    return 1;
+  }
+
+  fflush(stdout);
+  for (int i = 0; i < count; i++) {
+    memset(result, 0, sizeof(*result));
+    if (!run_child(names[i], false) || !run_child(names[i], true)) {
+      printf("%-16s (%s)\n", names[i], result->error[0] ? result->error : "failed");
+      fflush(stdout);
+      continue;
+    }
+    printf("%-16s %10.2f %8lu %8lu %8lu %8lu %10lu %10ld %10ld %8ld\n", names[i],
+	   result->nanos ? op_count * 1000.0 / result->nanos : 0.0,
+	   bench_percentile(result->histogram, 0.50),
+	   bench_percentile(result->histogram, 0.90),
+	   bench_percentile(result->histogram, 0.99),
+	   bench_percentile(result->histogram, 0.999), result->max_cycles, result->maxrss_kb,
+	   result->base_rss_kb, result->minflt);
+    fflush(stdout);
+  }
+  printf("(latencies in cycles)\n");
+  return 0;
+
+} // main()
+// ==============================================================================
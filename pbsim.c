@@ -0,0 +1,740 @@
+// ==============================================================================
+/**
+ * pbsim.c
+ *
+ * Simulate how allocation policies would lay out the blocks of an allocation
+ * trace (see `pb-trace.h`), without running the program that made it or any
+ * allocator at all.
+ *
+ *   pbsim [-t interval] <trace>
+ *
+ * Three policies are modeled, each over an address space of its own:
+ *
+ *   bump        : `pb-alloc.c` itself.  Each block takes its size plus a
+ *                 `header_s`, rounded to a double word; only the most recent
+ *                 block is reclaimed when freed; and `realloc()` stays in
+ *                 place only if the new size fits the original request.
+ *   best-fit    : boundary-tagged chunks of at least 32 bytes, each with an
+ *                 8-byte header, taken from the smallest free chunk that fits
+ *                 and split, coalesced with free neighbors when freed, and
+ *                 handed back from the top of the heap when freed there.
+ *   segregated  : headerless blocks rounded up to a size class (double words
+ *                 to 256 bytes, then four classes per power of two), reused
+ *                 only within their class and never handed back; blocks over
+ *                 64 KB are mapped by the page, and unmapped when freed.
+ *
+ * The footprint of a policy is the span of its heap (plus, for segregated,
+ * the pages mapped for large blocks), which is what it would hold from the
+ * system.  The live bytes are the bytes requested by blocks not yet freed, and
+ * are the same for every policy.  With `-t`, a timeline of the live bytes and
+ * each footprint is printed every `interval` events; the peaks and the
+ * fragmentation (footprint over live bytes) follow at the end.
+ *
+ * Each policy does constant work per event, apart from the search of one
+ * best-fit bin for its smallest fitting chunk, so a trace of a billion events
+ * takes minutes.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "bench.h"
+#include "pb-trace-read.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// CONSTANTS
+
+/** No slot, or no chunk. */
+#define NONE PB_TRACE_NO_SLOT
+
+/** The bump policy's header, and its alignment. */
+#define BUMP_HEADER 8
+#define BUMP_ALIGN  16
+
+/** The best-fit policy's chunks: header, alignment, and smallest size. */
+#define FIT_HEADER    8
+#define FIT_ALIGN     16
+#define FIT_MIN_CHUNK 32
+
+/** The best-fit bins: one per chunk size below `FIT_EXACT_LIMIT`, and then
+ *  `FIT_SUB_BINS` per power of two. */
+#define FIT_EXACT_LIMIT 4096
+#define FIT_EXACT_BINS  (FIT_EXACT_LIMIT / FIT_ALIGN)
+#define FIT_SUB_BITS    2
+#define FIT_SUB_BINS    (1 << FIT_SUB_BITS)
+#define FIT_BINS        (FIT_EXACT_BINS + (64 - 12) * FIT_SUB_BINS)
+#define FIT_BIN_WORDS   ((FIT_BINS + 63) / 64)
+
+/** The segregated policy's classes, and the largest block given one. */
+#define SEG_SMALL_LIMIT 256
+#define SEG_LARGE_LIMIT (64 * 1024)
+#define SEG_CLASSES     64
+#define SEG_PAGE        4096
+
+/** The default interval of the timeline, in events. */
+#define DEFAULT_INTERVAL (1 << 20)
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES AND STRUCTURES
+
+/** What each policy has held from the system, now and at most. */
+typedef struct footprint {
+
+  const char* name;
+  uint64_t    now;
+  uint64_t    peak;
+
+  /** The live bytes when the footprint peaked. */
+  uint64_t    live_at_peak;
+
+} footprint_s;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// GLOBALS
+
+/** The slots of the trace's blocks, and room in the tables below for how many. */
+static pb_trace_slots_s names;
+static size_t           slot_capacity = 0;
+
+/** By slot: the bytes last requested for each block. */
+static uint64_t*        requested     = NULL;
+
+/** The bytes requested by live blocks, now and at most. */
+static uint64_t         live          = 0;
+static uint64_t         peak_live     = 0;
+
+/** By slot: where the bump policy put each block, and the size in its header. */
+static uint64_t*        bump_addr     = NULL;
+static uint64_t*        bump_size     = NULL;
+static uint64_t         bump_cursor   = 0;
+
+/** By slot: the best-fit chunk of each block. */
+static uint32_t*        fit_chunk     = NULL;
+
+/** By slot: the segregated policy's rounded size for each block. */
+static uint64_t*        seg_size      = NULL;
+
+/** The footprints, in the order of the policies above. */
+static footprint_s      footprints[3] = {
+  { "bump" }, { "best-fit" }, { "segregated" }
+};
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Grow a table indexed by slot or by chunk, failing outright if it cannot.
+ *
+ * \param table    The table, which is moved.
+ * \param capacity The entries it has.
+ * \param wanted   The entries it should have.
+ * \param entry    The size of an entry.
+ */
+static void grow_table (void** table, size_t capacity, size_t wanted, size_t entry) {
+
+  void* grown = pb_trace_map_table(*table, capacity * entry, wanted * entry);
+  if (grown == NULL) {
+    fprintf(stderr, "pbsim: cannot map %zu bytes\n", wanted * entry);
+    exit(1);
+  }
+  *table = grown;
+
+} // grow_table ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Make room in the tables indexed by slot for every slot handed out so far.
+ */
+static inline void reserve_slots () {
+
+  if (names.count <= slot_capacity) {
+    return;
+  }
+  size_t wanted = slot_capacity ? 2 * slot_capacity : 1024;
+  grow_table((void**)&requested, slot_capacity, wanted, sizeof(uint64_t));
+  grow_table((void**)&bump_addr, slot_capacity, wanted, sizeof(uint64_t));
+  grow_table((void**)&bump_size, slot_capacity, wanted, sizeof(uint64_t));
+  grow_table((void**)&fit_chunk, slot_capacity, wanted, sizeof(uint32_t));
+  grow_table((void**)&seg_size,  slot_capacity, wanted, sizeof(uint64_t));
+  slot_capacity = wanted;
+
+} // reserve_slots ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+// THE BUMP POLICY
+
+/** The footprint of a block; see `block_footprint()` in `pb-alloc.c`. */
+static inline uint64_t bump_footprint (uint64_t size) {
+  return (size + BUMP_HEADER + BUMP_ALIGN - 1) & -(uint64_t)BUMP_ALIGN;
+}
+
+static inline void bump_malloc (uint32_t slot, uint64_t size) {
+
+  bump_addr[slot]  = bump_cursor;
+  bump_size[slot]  = size;
+  bump_cursor     += bump_footprint(size);
+
+}
+
+static inline void bump_free (uint32_t slot) {
+
+  if (bump_addr[slot] + bump_footprint(bump_size[slot]) == bump_cursor) {
+    bump_cursor = bump_addr[slot];
+  }
+
+}
+
+static inline void bump_realloc (uint32_t slot, uint64_t size) {
+
+  // As with `realloc()` in `pb-alloc.c`, the new block is allocated before
+  // the old one is freed, and so the old one is never reclaimed.
+  if (size > bump_size[slot]) {
+    bump_malloc(slot, size);
+  }
+
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+// THE BEST-FIT POLICY
+
+/** By chunk: its address and size; its neighbors in the heap; its neighbors
+ *  in its bin, while it is free; and whether it is free. */
+static uint64_t* chunk_addr     = NULL;
+static uint64_t* chunk_size     = NULL;
+static uint32_t* chunk_prev     = NULL;
+static uint32_t* chunk_next     = NULL;
+static uint32_t* chunk_bin_prev = NULL;
+static uint32_t* chunk_bin_next = NULL;
+static uint8_t*  chunk_free     = NULL;
+
+/** Chunk records: room for how many, those handed out, and those given back
+ *  (chained through `chunk_next`). */
+static size_t    chunk_capacity = 0;
+static uint32_t  chunk_count    = 0;
+static uint32_t  chunk_spare    = NONE;
+
+/** The chunk at the top of the heap, and the top itself. */
+static uint32_t  fit_last       = NONE;
+static uint64_t  fit_top        = 0;
+
+/** The first free chunk of each bin, and which bins have any. */
+static uint32_t  bins[FIT_BINS];
+static uint64_t  bin_map[FIT_BIN_WORDS];
+
+
+
+/** The chunk size that holds a request. */
+static inline uint64_t fit_chunk_size (uint64_t size) {
+
+  uint64_t chunk = (size + FIT_HEADER + FIT_ALIGN - 1) & -(uint64_t)FIT_ALIGN;
+  return chunk < FIT_MIN_CHUNK ? FIT_MIN_CHUNK : chunk;
+
+}
+
+/** The bin that holds chunks of a size. */
+static inline unsigned int bin_of (uint64_t size) {
+
+  if (size < FIT_EXACT_LIMIT) {
+    return size / FIT_ALIGN;
+  }
+  unsigned int exponent = 63 - __builtin_clzll(size);
+  return (FIT_EXACT_BINS + (exponent - 12) * FIT_SUB_BINS
+	  + ((size >> (exponent - FIT_SUB_BITS)) & (FIT_SUB_BINS - 1)));
+
+}
+
+/** The first bin after `bin` that has a chunk, or `FIT_BINS` if none does. */
+static inline unsigned int next_bin (unsigned int bin) {
+
+  for (unsigned int word = (bin + 1) / 64; word < FIT_BIN_WORDS; word++) {
+    uint64_t bits = bin_map[word];
+    if (word == (bin + 1) / 64) {
+      bits &= -(1ULL << ((bin + 1) % 64));
+    }
+    if (bits != 0) {
+      return word * 64 + __builtin_ctzll(bits);
+    }
+  }
+  return FIT_BINS;
+
+}
+
+/** A chunk record, from those given back or a new one. */
+static uint32_t new_chunk (uint64_t addr, uint64_t size) {
+
+  uint32_t chunk = chunk_spare;
+  if (chunk != NONE) {
+    chunk_spare = chunk_next[chunk];
+  } else {
+    if (chunk_count == chunk_capacity) {
+      size_t wanted = chunk_capacity ? 2 * chunk_capacity : 1024;
+      grow_table((void**)&chunk_addr,     chunk_capacity, wanted, sizeof(uint64_t));
+      grow_table((void**)&chunk_size,     chunk_capacity, wanted, sizeof(uint64_t));
+      grow_table((void**)&chunk_prev,     chunk_capacity, wanted, sizeof(uint32_t));
+      grow_table((void**)&chunk_next,     chunk_capacity, wanted, sizeof(uint32_t));
+      grow_table((void**)&chunk_bin_prev, chunk_capacity, wanted, sizeof(uint32_t));
+      grow_table((void**)&chunk_bin_next, chunk_capacity, wanted, sizeof(uint32_t));
+      grow_table((void**)&chunk_free,     chunk_capacity, wanted, sizeof(uint8_t));
+      chunk_capacity = wanted;
+    }
+    chunk = chunk_count++;
+  }
+  chunk_addr[chunk] = addr;
+  chunk_size[chunk] = size;
+  chunk_prev[chunk] = NONE;
+  chunk_next[chunk] = NONE;
+  chunk_free[chunk] = 0;
+  return chunk;
+
+}
+
+static inline void drop_chunk (uint32_t chunk) {
+
+  chunk_next[chunk] = chunk_spare;
+  chunk_spare       = chunk;
+
+}
+
+static inline void bin_insert (uint32_t chunk) {
+
+  unsigned int bin = bin_of(chunk_size[chunk]);
+  chunk_free[chunk]     = 1;
+  chunk_bin_prev[chunk] = NONE;
+  chunk_bin_next[chunk] = bins[bin];
+  if (bins[bin] != NONE) {
+    chunk_bin_prev[bins[bin]] = chunk;
+  }
+  bins[bin]           = chunk;
+  bin_map[bin / 64] |= 1ULL << (bin % 64);
+
+}
+
+static inline void bin_remove (uint32_t chunk) {
+
+  unsigned int bin = bin_of(chunk_size[chunk]);
+  chunk_free[chunk] = 0;
+  if (chunk_bin_prev[chunk] != NONE) {
+    chunk_bin_next[chunk_bin_prev[chunk]] = chunk_bin_next[chunk];
+  } else {
+    bins[bin] = chunk_bin_next[chunk];
+    if (bins[bin] == NONE) {
+      bin_map[bin / 64] &= ~(1ULL << (bin % 64));
+    }
+  }
+  if (chunk_bin_next[chunk] != NONE) {
+    chunk_bin_prev[chunk_bin_next[chunk]] = chunk_bin_prev[chunk];
+  }
+
+}
+
+/** Link `chunk` into the heap after `prev`. */
+static inline void link_after (uint32_t prev, uint32_t chunk) {
+
+  chunk_prev[chunk] = prev;
+  chunk_next[chunk] = chunk_next[prev];
+  if (chunk_next[prev] != NONE) {
+    chunk_prev[chunk_next[prev]] = chunk;
+  } else {
+    fit_last = chunk;
+  }
+  chunk_next[prev] = chunk;
+
+}
+
+/** Unlink `chunk` from the heap. */
+static inline void unlink_chunk (uint32_t chunk) {
+
+  if (chunk_prev[chunk] != NONE) {
+    chunk_next[chunk_prev[chunk]] = chunk_next[chunk];
+  }
+  if (chunk_next[chunk] != NONE) {
+    chunk_prev[chunk_next[chunk]] = chunk_prev[chunk];
+  } else {
+    fit_last = chunk_prev[chunk];
+  }
+
+}
+
+/** Free a chunk that is in use or has just been split off: coalesce it with
+ *  its free neighbors, and hand it back if it ends up at the top. */
+static void fit_release (uint32_t chunk) {
+
+  uint32_t next = chunk_next[chunk];
+  if (next != NONE && chunk_free[next]) {
+    bin_remove(next);
+    chunk_size[chunk] += chunk_size[next];
+    unlink_chunk(next);
+    drop_chunk(next);
+  }
+  uint32_t prev = chunk_prev[chunk];
+  if (prev != NONE && chunk_free[prev]) {
+    bin_remove(prev);
+    chunk_size[prev] += chunk_size[chunk];
+    unlink_chunk(chunk);
+    drop_chunk(chunk);
+    chunk = prev;
+  }
+
+  if (chunk == fit_last) {
+    fit_top = chunk_addr[chunk];
+    unlink_chunk(chunk);
+    drop_chunk(chunk);
+  } else {
+    bin_insert(chunk);
+  }
+
+}
+
+/** Trim a chunk in use down to `need` bytes, freeing what is left over if it
+ *  makes a chunk. */
+static inline void fit_split (uint32_t chunk, uint64_t need) {
+
+  uint64_t rest = chunk_size[chunk] - need;
+  if (rest >= FIT_MIN_CHUNK) {
+    chunk_size[chunk] = need;
+    uint32_t tail = new_chunk(chunk_addr[chunk] + need, rest);
+    link_after(chunk, tail);
+    fit_release(tail);
+  }
+
+}
+
+/** The smallest free chunk in a bin of at least `need` bytes, or `NONE`. */
+static inline uint32_t best_in_bin (unsigned int bin, uint64_t need) {
+
+  uint32_t best = NONE;
+  for (uint32_t chunk = bins[bin]; chunk != NONE; chunk = chunk_bin_next[chunk]) {
+    if (chunk_size[chunk] >= need &&
+	(best == NONE || chunk_size[chunk] < chunk_size[best])) {
+      best = chunk;
+      if (chunk_size[chunk] == need) {
+	break;
+      }
+    }
+  }
+  return best;
+
+}
+
+static uint32_t fit_malloc_chunk (uint64_t size) {
+
+  uint64_t     need  = fit_chunk_size(size);
+  unsigned int bin   = bin_of(need);
+  uint32_t     chunk = bin < FIT_EXACT_BINS ? bins[bin] : best_in_bin(bin, need);
+  if (chunk == NONE) {
+    bin = next_bin(bin);
+    if (bin < FIT_BINS) {
+      chunk = bin < FIT_EXACT_BINS ? bins[bin] : best_in_bin(bin, need);
+    }
+  }
+
+  if (chunk != NONE) {
+    bin_remove(chunk);
+    fit_split(chunk, need);
+    return chunk;
+  }
+
+  // Nothing fits, so extend the heap.
+  chunk = new_chunk(fit_top, need);
+  if (fit_last != NONE) {
+    link_after(fit_last, chunk);
+  } else {
+    fit_last = chunk;
+  }
+  fit_top += need;
+  return chunk;
+
+}
+
+static inline void fit_malloc (uint32_t slot, uint64_t size) {
+  fit_chunk[slot] = fit_malloc_chunk(size);
+}
+
+static inline void fit_free (uint32_t slot) {
+  fit_release(fit_chunk[slot]);
+}
+
+static void fit_realloc (uint32_t slot, uint64_t size) {
+
+  uint32_t chunk = fit_chunk[slot];
+  uint64_t need  = fit_chunk_size(size);
+  uint32_t next  = chunk_next[chunk];
+
+  if (need <= chunk_size[chunk]) {
+    fit_split(chunk, need);
+  } else if (next != NONE && chunk_free[next] &&
+	     chunk_size[chunk] + chunk_size[next] >= need) {
+    bin_remove(next);
+    chunk_size[chunk] += chunk_size[next];
+    unlink_chunk(next);
+    drop_chunk(next);
+    fit_split(chunk, need);
+  } else if (chunk == fit_last) {
+    fit_top           += need - chunk_size[chunk];
+    chunk_size[chunk]  = need;
+  } else {
+    fit_chunk[slot] = fit_malloc_chunk(size);
+    fit_release(chunk);
+  }
+
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+// THE SEGREGATED POLICY
+
+/** The free blocks of each class, the top of the heap of small blocks, and
+ *  the bytes mapped for large ones. */
+static uint64_t seg_free[SEG_CLASSES];
+static uint64_t seg_top    = 0;
+static uint64_t seg_mapped = 0;
+
+/** The class of a rounded size. */
+static inline unsigned int seg_class (uint64_t rounded) {
+
+  if (rounded <= SEG_SMALL_LIMIT) {
+    return rounded / 16 - 1;
+  }
+  unsigned int exponent = 63 - __builtin_clzll(rounded - 1);
+  return (SEG_SMALL_LIMIT / 16 + (exponent - 8) * 4
+	  + (((rounded - 1) >> (exponent - 2)) & 3));
+
+}
+
+/** Round a request up to its class, or to whole pages if it is large. */
+static inline uint64_t seg_round (uint64_t size) {
+
+  if (size <= SEG_SMALL_LIMIT) {
+    return size == 0 ? 16 : (size + 15) & -(uint64_t)16;
+  }
+  if (size > SEG_LARGE_LIMIT) {
+    return (size + SEG_PAGE - 1) & -(uint64_t)SEG_PAGE;
+  }
+  unsigned int exponent = 63 - __builtin_clzll(size - 1);
+  uint64_t     step     = 1ULL << (exponent - 2);
+  return (size + step - 1) & -step;
+
+}
+
+static inline void seg_malloc (uint32_t slot, uint64_t size) {
+
+  uint64_t rounded = seg_round(size);
+  seg_size[slot]   = rounded;
+  if (rounded > SEG_LARGE_LIMIT) {
+    seg_mapped += rounded;
+    return;
+  }
+  unsigned int class = seg_class(rounded);
+  if (seg_free[class] > 0) {
+    seg_free[class]--;
+  } else {
+    seg_top += rounded;
+  }
+
+}
+
+static inline void seg_free_block (uint32_t slot) {
+
+  uint64_t rounded = seg_size[slot];
+  if (rounded > SEG_LARGE_LIMIT) {
+    seg_mapped -= rounded;
+  } else {
+    seg_free[seg_class(rounded)]++;
+  }
+
+}
+
+static inline void seg_realloc (uint32_t slot, uint64_t size) {
+
+  if (seg_round(size) != seg_size[slot]) {
+    uint64_t old = seg_size[slot];
+    seg_malloc(slot, size);
+    uint64_t new_size = seg_size[slot];
+    seg_size[slot] = old;
+    seg_free_block(slot);
+    seg_size[slot] = new_size;
+  }
+
+}
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Apply one event to every policy.
+ *
+ * \param event The event.
+ * \param in    The slot of the block passed in, if any.
+ * \param out   The slot of the block returned, if any.
+ */
+static void simulate (const pb_trace_event_s* event, uint32_t in, uint32_t out) {
+
+  if (in != NONE && out == in) {
+    live           += event->size - requested[in];
+    requested[in]   = event->size;
+    bump_realloc(in, event->size);
+    fit_realloc(in, event->size);
+    seg_realloc(in, event->size);
+    return;
+  }
+
+  if (in != NONE) {
+    live -= requested[in];
+    bump_free(in);
+    fit_free(in);
+    seg_free_block(in);
+  }
+  if (out != NONE) {
+    live           += event->size;
+    requested[out]  = event->size;
+    bump_malloc(out, event->size);
+    fit_malloc(out, event->size);
+    seg_malloc(out, event->size);
+  }
+
+} // simulate ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Bring the footprints up to date, and their peaks.
+ */
+static inline void measure () {
+
+  footprints[0].now = bump_cursor;
+  footprints[1].now = fit_top;
+  footprints[2].now = seg_top + seg_mapped;
+  for (int policy = 0; policy < 3; policy++) {
+    if (footprints[policy].now > footprints[policy].peak) {
+      footprints[policy].peak         = footprints[policy].now;
+      footprints[policy].live_at_peak = live;
+    }
+  }
+  if (live > peak_live) {
+    peak_live = live;
+  }
+
+} // measure ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  uint64_t interval = 0;
+  int      option;
+  while ((option = getopt(argc, argv, "t:")) != -1) {
+    if (option == 't') {
+      interval = strtoull(optarg, NULL, 10);
+      interval = interval ? interval : DEFAULT_INTERVAL;
+    } else {
+      optind = argc + 1;
+    }
+  }
+  if (optind != argc - 1) {
+    fprintf(stderr, "usage: %s [-t interval] <trace>\n", argv[0]);
+    return 2;
+  }
+
+  pb_trace_file_s trace;
+  if (!pb_trace_open(argv[optind], &trace)) {
+    return 1;
+  }
+  if (!pb_trace_slots_init(&names)) {
+    fprintf(stderr, "pbsim: cannot map the slot tables\n");
+    return 1;
+  }
+  for (unsigned int bin = 0; bin < FIT_BINS; bin++) {
+    bins[bin] = NONE;
+  }
+
+  if (interval != 0) {
+    printf("%14s %14s %14s %14s %14s\n", "event", "live",
+	   footprints[0].name, footprints[1].name, footprints[2].name);
+  }
+
+  pb_trace_event_s prev   = { 0 };
+  pb_trace_event_s event;
+  const uint8_t*   next   = trace.begin;
+  uint64_t         events = 0;
+  uint64_t         skipped = 0;
+  uint64_t         start  = bench_nanos();
+  while (pb_trace_decode(&next, trace.end, &prev, &event)) {
+    if (event.op == PB_TRACE_CLOCK) {
+      continue;
+    }
+    uint32_t in, out;
+    if (!pb_trace_slots_resolve(&names, &event, &in, &out)) {
+      skipped++;
+      continue;
+    }
+    reserve_slots();
+    simulate(&event, in, out);
+    measure();
+
+    if (interval != 0 && ++events % interval == 0) {
+      printf("%14lu %14lu %14lu %14lu %14lu\n", events, live,
+	     footprints[0].now, footprints[1].now, footprints[2].now);
+    } else if (interval == 0) {
+      events++;
+    }
+  }
+  uint64_t elapsed = bench_nanos() - start;
+  if (next != trace.end) {
+    fprintf(stderr, "pbsim: the trace is truncated\n");
+  }
+
+  printf("%lu events (%lu skipped) in %.2f s; %u blocks live at most, "
+	 "%lu bytes live at most\n", events, skipped, elapsed / 1e9,
+	 names.count, peak_live);
+  printf("%-12s %16s %16s %10s %16s %10s\n", "policy", "peak footprint",
+	 "live then", "ratio", "final footprint", "ratio");
+  for (int policy = 0; policy < 3; policy++) {
+    footprint_s* footprint = &footprints[policy];
+    printf("%-12s %16lu %16lu %10.3f %16lu %10.3f\n", footprint->name,
+	   footprint->peak, footprint->live_at_peak,
+	   footprint->live_at_peak ? (double)footprint->peak / footprint->live_at_peak : 0.0,
+	   footprint->now,
+	   live ? (double)footprint->now / live : 0.0);
+  }
+
+  pb_trace_close(&trace);
+  return 0;
+
+} // main()
+// ==============================================================================
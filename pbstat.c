@@ -0,0 +1,176 @@
+// ==============================================================================
+/**
+ * pbstat.c
+ *
+ * Watch a running process's _pointer-bumping_ heap through the statistics page
+ * that a `PB_STATS` build publishes when `PB_SHM_STATS=1` is set.  The page is
+ * mapped read-only, so the process is never stopped or disturbed.
+ *
+ *   pbstat [-c] <pid> [interval]
+ *
+ * Every `interval` seconds (one, by default), print the heap in use, its peak,
+ * the dead bytes, and the rate of calls to each entry point since the last
+ * line; with `-c`, follow each line with the rate of allocations in each size
+ * class.  Stops when the process exits.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "pb-shm.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Map the statistics page of process `pid`.
+ *
+ * \param pid The process to watch.
+ * \return    The page, if successful; `NULL` if not, with a message printed.
+ */
+static const pb_shm_page_s* attach (long pid) {
+
+  char path[64];
+  snprintf(path, sizeof(path), "%s%ld", PB_SHM_PREFIX, pid);
+
+  int fd = open(path, O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+  if (fd < 0) {
+    fprintf(stderr, "pbstat: cannot open %s: %s\n"
+	    "  (is the process using libpb-stats.so with %s=1?)\n",
+	    path, strerror(errno), PB_SHM_ENV);
+    return NULL;
+  }
+  void* page = mmap(NULL, sizeof(pb_shm_page_s), PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (page == MAP_FAILED) {
+    fprintf(stderr, "pbstat: cannot map %s: %s\n", path, strerror(errno));
+    return NULL;
+  }
+
+  const pb_shm_page_s* shared = page;
+  if (__atomic_load_n(&shared->magic, __ATOMIC_ACQUIRE) != PB_SHM_MAGIC ||
+      shared->version != PB_SHM_VERSION) {
+    fprintf(stderr, "pbstat: %s is not a version %d statistics page\n",
+	    path, PB_SHM_VERSION);
+    return NULL;
+  }
+  return shared;
+
+} // attach ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Print the upper bound of a size class compactly, e.g. `512`, `4K`, `1M`.
+ *
+ * \param class The size class.
+ */
+static void print_class (unsigned int class) {
+
+  static const char units[] = { ' ', 'K', 'M', 'G' };
+  unsigned int      bits    = class;
+  int               unit    = 0;
+  while (bits >= 10 && unit < 3) {
+    bits -= 10;
+    unit++;
+  }
+  if (class == PB_SHM_CLASSES - 1) {
+    printf(" >%lu%c", 1UL << (bits - 1), units[unit]);
+  } else if (unit == 0) {
+    printf(" %lu", 1UL << bits);
+  } else {
+    printf(" %lu%c", 1UL << bits, units[unit]);
+  }
+
+} // print_class ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  bool classes = false;
+  int  arg     = 1;
+  if (arg < argc && strcmp(argv[arg], "-c") == 0) {
+    classes = true;
+    arg++;
+  }
+  if (arg >= argc) {
+    fprintf(stderr, "usage: %s [-c] <pid> [interval]\n", argv[0]);
+    return 2;
+  }
+  long pid      = strtol(argv[arg++], NULL, 10);
+  int  interval = arg < argc ? atoi(argv[arg]) : 1;
+  if (pid <= 0 || interval <= 0) {
+    fprintf(stderr, "usage: %s [-c] <pid> [interval]\n", argv[0]);
+    return 2;
+  }
+
+  const pb_shm_page_s* shared = attach(pid);
+  if (shared == NULL) {
+    return 1;
+  }
+
+  pb_shm_page_s last;
+  pb_shm_page_s now;
+  if (!pb_shm_read(shared, &last)) {
+    fprintf(stderr, "pbstat: the page never settled\n");
+    return 1;
+  }
+
+  for (int line = 0; kill(pid, 0) == 0 || errno == EPERM; line++) {
+    if (line % 20 == 0) {
+      printf("%12s %12s %12s %10s %10s %10s %10s\n", "in use", "peak", "dead",
+	     "malloc/s", "free/s", "calloc/s", "realloc/s");
+    }
+
+    sleep(interval);
+    if (!pb_shm_read(shared, &now)) {
+      continue;
+    }
+
+    size_t in_use = ((now.free_addr - now.start_addr)
+		     + (now.limit_addr - now.end_addr));
+    printf("%12zu %12zu %12zu %10zu %10zu %10zu %10zu\n",
+	   in_use, now.stats.peak, now.stats.dead_bytes,
+	   (now.stats.malloc_calls  - last.stats.malloc_calls)  / interval,
+	   (now.stats.free_calls    - last.stats.free_calls)    / interval,
+	   (now.stats.calloc_calls  - last.stats.calloc_calls)  / interval,
+	   (now.stats.realloc_calls - last.stats.realloc_calls) / interval);
+
+    if (classes) {
+      printf("   per class:");
+      for (unsigned int class = 0; class < PB_SHM_CLASSES; class++) {
+	uint64_t count = now.histogram[class] - last.histogram[class];
+	if (count != 0) {
+	  print_class(class);
+	  printf(":%lu", (unsigned long)(count / interval));
+	}
+      }
+      printf("\n");
+    }
+
+    fflush(stdout);
+    last = now;
+  }
+
+  return 0;
+
+} // main()
+// ==============================================================================
@@ -0,0 +1,115 @@
+// ==============================================================================
+/**
+ * resourcetest.cpp
+ *
+ * Check `pb::bump_resource`: that a block larger than the first chunk is
+ * served, never null, at the alignment asked for; that blocks of odd sizes
+ * deallocated in LIFO order hand the arena back exactly; and that a request too
+ * large for any chunk throws `std::bad_alloc` rather than wrapping.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <new>
+
+#include "pb-resource.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate blocks larger than any chunk so far from `resource`, at several
+ * alignments, and write to every byte of each.
+ */
+static void check_large (pb::bump_resource& resource) {
+
+  for (std::size_t align = 1; align <= 4096; align *= 8) {
+    for (std::size_t size : { std::size_t(4801), std::size_t(65537) }) {
+      char* block = static_cast<char*>(resource.allocate(size, align));
+      assert(block != nullptr);
+      assert(reinterpret_cast<std::uintptr_t>(block) % align == 0);
+      for (std::size_t i = 0; i < size; i++) {
+	block[i] = char(i);
+      }
+    }
+  }
+
+} // check_large ()
+
+
+
+/** Nest blocks of odd sizes, then deallocate them newest first. */
+static void check_lifo (pb::bump_resource& resource) {
+
+  static const std::size_t sizes[] = { 1, 3, 7, 9, 13, 17, 31, 33, 45, 100 };
+  constexpr std::size_t    count   = sizeof(sizes) / sizeof(sizes[0]);
+
+  // Start on a fresh chunk, so that every block below fits in it.
+  resource.deallocate(resource.allocate(8192, 16), 8192, 16);
+  pb_mark_s start = pb_arena_mark(resource.arena());
+  void*     blocks[count];
+  for (std::size_t i = 0; i < count; i++) {
+    blocks[i] = resource.allocate(sizes[i], i % 2 == 0 ? 8 : 16);
+  }
+  for (std::size_t i = count; i-- > 0; ) {
+    resource.deallocate(blocks[i], sizes[i], i % 2 == 0 ? 8 : 16);
+  }
+  assert(resource.arena()->free_addr == start.free_addr);  // every block should
+  assert(resource.arena()->end_addr  == start.end_addr);   // have come back
+
+} // check_lifo ()
+
+
+
+/** Ask for more than any chunk could hold. */
+static void check_too_large (pb::bump_resource& resource) {
+
+  for (std::size_t size : { std::size_t(PB_MAX_SIZE), std::size_t(PB_MAX_SIZE) - 64,
+			    std::size_t(-1) }) {
+    bool thrown = false;
+    try {
+      (void)resource.allocate(size, 16);
+    } catch (const std::bad_alloc&) {
+      thrown = true;
+    }
+    assert(thrown);
+  }
+
+} // check_too_large ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  {
+    // Every block comes from upstream.
+    pb::bump_resource resource(0);
+    check_large(resource);
+    check_lifo(resource);
+    check_too_large(resource);
+  }
+
+  {
+    // The first block comes from the heap, and the rest from upstream.
+    pb::bump_resource resource(4096);
+    check_lifo(resource);
+    check_large(resource);
+    resource.release();
+    check_large(resource);
+  }
+
+  std::printf("resourcetest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================
@@ -39,6 +39,9 @@
 /** The maximum length of debugging/error messages. */
 #define MAX_MESSAGE_LENGTH 256
 
+/** The most characters that a padded decimal integer may take. */
+#define MAX_DECIMAL_LENGTH 32
+
 #define TAB_STRING "\t"
 #define TAB_LENGTH 1
 
@@ -159,3 +162,75 @@ safe_error (const char* msg, int argc, ...) {
   
 } // safe_error ()
 // ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Write a string to a file descriptor.
+ *
+ * \param fd  The file descriptor to write to.
+ * \param str The string to write.  Cannot be longer than 256 characters.
+ */
+void
+safe_puts (int fd, const char* str) {
+
+  write(fd, str, strnlen(str, MAX_MESSAGE_LENGTH));
+
+} // safe_puts ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Write an unsigned integer in decimal to a file descriptor, right-aligned.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param value The integer to write.
+ * \param width The least number of characters to write, padding with spaces.
+ */
+void
+safe_putu (int fd, uint64_t value, int width) {
+
+  // Fill the buffer from the right: the digits, then any padding.
+  char  buffer[MAX_DECIMAL_LENGTH];
+  char* end     = buffer + MAX_DECIMAL_LENGTH;
+  char* current = end;
+  do {
+    *--current = '0' + value % 10;
+    value      = value / 10;
+  } while (value != 0);
+
+  if (width > MAX_DECIMAL_LENGTH) {
+    width = MAX_DECIMAL_LENGTH;
+  }
+  while (end - current < width) {
+    *--current = ' ';
+  }
+
+  write(fd, current, end - current);
+
+} // safe_putu ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Write an unsigned integer in hexadecimal, prefixed with `0x`, to a file
+ * descriptor.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param value The integer to write.
+ */
+void
+safe_putx (int fd, uint64_t value) {
+
+  char buffer[MAX_MESSAGE_LENGTH];
+  int_to_hex(buffer, value);
+  write(fd, "0x", 2);
+  write(fd, buffer, strnlen(buffer, MAX_MESSAGE_LENGTH));
+
+} // safe_putx ()
+// ==============================================================================
@@ -17,6 +17,14 @@
 
 
 
+// ==============================================================================
+// INCLUDES
+
+#include <stdint.h>
+// ==============================================================================
+
+
+
 // ==============================================================================
 // MACROS
 
@@ -57,6 +65,32 @@ void safe_debug (const char* msg, int argc, ...);
  *             the output.
  */
 void safe_error (const char* msg, int argc, ...);
+
+/**
+ * Write a string to a file descriptor.
+ *
+ * \param fd  The file descriptor to write to.
+ * \param str The string to write.  Cannot be longer than 256 characters.
+ */
+void safe_puts (int fd, const char* str);
+
+/**
+ * Write an unsigned integer in decimal to a file descriptor, right-aligned.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param value The integer to write.
+ * \param width The least number of characters to write, padding with spaces.
+ */
+void safe_putu (int fd, uint64_t value, int width);
+
+/**
+ * Write an unsigned integer in hexadecimal, prefixed with `0x`, to a file
+ * descriptor.
+ *
+ * \param fd    The file descriptor to write to.
+ * \param value The integer to write.
+ */
+void safe_putx (int fd, uint64_t value);
 // ==============================================================================
 
 
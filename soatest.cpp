@@ -0,0 +1,156 @@
+// ==============================================================================
+/**
+ * soatest.cpp
+ *
+ * Check struct-of-arrays blocks: that `pb::basic_soa_block` lays out columns of
+ * mixed element types at the offsets and alignments it promises, at compile
+ * time and in the block it allocates; that zero rows still make a valid block;
+ * and that a row count whose total size would overflow is refused, by the
+ * class and by `pb_soa_alloc()`.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <utility>
+
+#include "pb-soa.hpp"
+// ==============================================================================
+
+
+
+// ==============================================================================
+// TYPES
+
+/** An element more strictly aligned than the columns are asked to be, and
+ *  padded out to 64 bytes by that alignment. */
+struct alignas(32) wide {
+  char bytes[48];
+};
+static_assert(sizeof(wide) == 64);
+
+/** Columns of every size and alignment, in an awkward order. */
+using mixed       = pb::basic_soa_block<16, char, double, std::int16_t, wide, float>;
+using cache_lines = pb::soa_block<std::uint8_t, std::uint64_t>;
+// ==============================================================================
+
+
+
+// ==============================================================================
+// LAYOUT
+
+static_assert(mixed::columns == 5);
+static_assert(mixed::alignments[0] == 16 && mixed::alignments[1] == 16 &&
+	      mixed::alignments[2] == 16 && mixed::alignments[3] == 32 &&
+	      mixed::alignments[4] == 16);
+static_assert(mixed::alignment == 32);
+static_assert(cache_lines::alignment == 64);
+
+// Three rows: 3 chars, then doubles from 16, shorts from 48, wides from 64 and
+// floats from 256.
+static_assert(mixed::layout(3).offsets[0] == 0);
+static_assert(mixed::layout(3).offsets[1] == 16);
+static_assert(mixed::layout(3).offsets[2] == 48);
+static_assert(mixed::layout(3).offsets[3] == 64);
+static_assert(mixed::layout(3).offsets[4] == 256);
+static_assert(mixed::layout(3).size       == 268);
+
+// No rows: every column starts at zero, and the block is empty.
+static_assert(mixed::layout(0).offsets[4] == 0 && mixed::layout(0).size == 0);
+
+// The most rows allowed still lay out without wrapping.
+static_assert(mixed::layout(mixed::max_rows).size > mixed::max_rows);
+static_assert(mixed::layout(mixed::max_rows).offsets[4] < mixed::layout(mixed::max_rows).size);
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Allocate a block of `rows` rows and check that each column is where the
+ * layout puts it, aligned, and can be filled without touching its neighbours.
+ */
+template <typename Block>
+static void check_block (std::size_t rows) {
+
+  Block      block(rows);
+  auto       shape = Block::layout(rows);
+  std::byte* base  = static_cast<std::byte*>(block.data());
+  assert(block.rows() == rows);
+  assert(block.size() >= shape.size);
+  assert(reinterpret_cast<std::uintptr_t>(base) % Block::alignment == 0);
+
+  void* columns[Block::columns];
+  [&]<std::size_t... I> (std::index_sequence<I...>) {
+    ((columns[I] = block.template column<I>()), ...);
+  }(std::make_index_sequence<Block::columns>());
+
+  for (std::size_t i = 0; i < Block::columns; i++) {
+    std::byte* column = static_cast<std::byte*>(columns[i]);
+    assert(column == base + shape.offsets[i]);
+    assert(reinterpret_cast<std::uintptr_t>(column) % Block::alignments[i] == 0);
+    std::memset(column, int(i + 1), Block::sizes[i] * rows);
+  }
+  for (std::size_t i = 0; i < Block::columns; i++) {
+    const unsigned char* column = static_cast<const unsigned char*>(columns[i]);
+    for (std::size_t j = 0; j < Block::sizes[i] * rows; j++) {
+      assert(column[j] == i + 1);
+    }
+  }
+
+} // check_block ()
+
+
+
+/** Ask for `rows` rows, and check that the block is refused. */
+template <typename Block>
+static void check_refused (std::size_t rows) {
+
+  bool thrown = false;
+  try {
+    Block block(rows);
+  } catch (const std::bad_array_new_length&) {
+    thrown = true;
+  }
+  assert(thrown);
+
+} // check_refused ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  for (std::size_t rows : { 0, 1, 3, 7, 100, 1001 }) {
+    check_block<mixed>(rows);
+    check_block<cache_lines>(rows);
+  }
+
+  check_refused<mixed>(mixed::max_rows + 1);
+  check_refused<mixed>(SIZE_MAX);
+  check_refused<cache_lines>(SIZE_MAX / 9 + 1);
+
+  // The C interface refuses a column whose size overflows, and no columns.
+  pb_column_s columns[] = { { 8, 8, nullptr }, { 1, 64, nullptr } };
+  assert(pb_soa_alloc(columns, 2, SIZE_MAX / 4, nullptr) == nullptr);
+  assert(pb_soa_alloc(columns, 0, 4, nullptr) == nullptr);
+  std::size_t size  = 0;
+  void*       block = pb_soa_alloc(columns, 2, 5, &size);
+  assert(block != nullptr && size == 64 + 5);
+  assert(columns[0].base == block);
+  assert(columns[1].base == static_cast<char*>(block) + 64);
+
+  std::printf("soatest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================
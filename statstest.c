@@ -0,0 +1,118 @@
+// ==============================================================================
+/**
+ * statstest.c
+ *
+ * Check the accounting of a `PB_STATS` build: blocks from `pb_malloc_batch()`,
+ * `pb_malloc_many()` and `pb_malloc()` are counted as calls to `malloc()`, and
+ * freeing them takes back exactly what they added; freeing a block from an
+ * inline bump that was never counted takes nothing, rather than wrapping the
+ * counts below zero.
+ **/
+// ==============================================================================
+
+
+
+// ==============================================================================
+// INCLUDES
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pb-alloc.h"
+// ==============================================================================
+
+
+
+// ==============================================================================
+/** \return The counts of `after` less those of `before`, field by field. */
+static pb_stats_s delta (const pb_stats_s* before, const pb_stats_s* after) {
+
+  pb_stats_s d = {
+    .requested     = after->requested     - before->requested,
+    .allocated     = after->allocated     - before->allocated,
+    .header_bytes  = after->header_bytes  - before->header_bytes,
+    .padding_bytes = after->padding_bytes - before->padding_bytes,
+    .malloc_calls  = after->malloc_calls  - before->malloc_calls,
+    .free_calls    = after->free_calls    - before->free_calls,
+  };
+  return d;
+
+} // delta ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+/**
+ * Carve a block as an inline `pb_malloc()` compiled without `PB_STATS` would,
+ * with the library none the wiser.
+ */
+__attribute__((noinline))
+static void* inline_malloc (size_t size) {
+
+  return pb_arena_alloc(&pb_heap, size);
+
+} // inline_malloc ()
+// ==============================================================================
+
+
+
+// ==============================================================================
+int main (int argc, char **argv) {
+
+  pb_stats_s start, now, d;
+  if (!pb_stats(&start)) {
+    fprintf(stderr, "The library was not built with PB_STATS\n");
+    return 1;
+  }
+
+  // Four blocks of 32 bytes, each taking a header and a 48-byte footprint.
+  void* out[4];
+  assert(pb_malloc_batch(32, 4, out) == out);
+  pb_stats(&now);
+  d = delta(&start, &now);
+  assert(d.malloc_calls == 4 && d.requested == 128);
+  assert(d.allocated == 4 * 48 && d.header_bytes == 4 * sizeof(pb_header_s));
+
+  // The last of them is reclaimed; then a block from pb_malloc() comes and
+  // goes, since this file is compiled with PB_STATS too.
+  free(out[3]);
+  free(pb_malloc(40));
+  pb_stats(&now);
+  d = delta(&start, &now);
+  assert(d.malloc_calls == 5 && d.free_calls == 2);
+  assert(d.requested == 96 && d.allocated == 3 * 48);
+  assert(d.header_bytes == 3 * sizeof(pb_header_s) && d.padding_bytes == 3 * 8);
+
+  // Blocks of assorted sizes, all reclaimed newest first.
+  size_t sizes[] = { 1, 17, 100 };
+  void*  many[3];
+  assert(pb_malloc_many(sizes, 3, many) == many);
+  pb_stats(&now);
+  d = delta(&start, &now);
+  assert(d.malloc_calls == 8 && d.requested == 96 + 118);
+  for (int i = 2; i >= 0; i--) {
+    free(many[i]);
+  }
+  free(out[2]);
+  free(out[1]);
+  free(out[0]);
+  pb_stats(&now);
+  d = delta(&start, &now);
+  assert(d.requested == 0 && d.allocated == 0 && d.header_bytes == 0);
+
+  // A block that was never counted is reclaimed, but takes nothing back.
+  void* uncounted = inline_malloc(1 << 20);
+  assert(uncounted != NULL);
+  free(uncounted);
+  pb_stats(&now);
+  d = delta(&start, &now);
+  assert(d.requested == 0 && d.allocated == 0 && d.header_bytes == 0);
+  assert(now.requested <= now.allocated && now.padding_bytes <= now.allocated);
+
+  printf("statstest: ok\n");
+  return 0;
+
+} // main ()
+// ==============================================================================